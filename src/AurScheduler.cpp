@@ -0,0 +1,366 @@
+#include "AurScheduler.hpp"
+#include "Config.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+const char *buildStateName(BuildState State) {
+  switch (State) {
+  case BuildState::Waiting: return "waiting";
+  case BuildState::Building: return "building";
+  case BuildState::Built: return "built";
+  case BuildState::Installing: return "installing";
+  case BuildState::Installed: return "installed";
+  case BuildState::Failed: return "failed";
+  case BuildState::Skipped: return "skipped";
+  }
+  return "unknown";
+}
+
+static std::string buildDir() { return cacheDir() + "/aur/build"; }
+
+static std::string pkgDestDir(const std::string &Name) { return std::format("{}/aur/pkgdest/{}", cacheDir(), Name); }
+
+// "foo>=1.2" -> "foo"
+static std::string stripVersion(std::string_view Dep) {
+  return std::string(Dep.substr(0, Dep.find_first_of("<>=:")));
+}
+
+// "foo-bar-1.0-1-x86_64.pkg.tar.zst" -> "foo-bar"; empty for anything else, like signatures
+static std::string packageFileName(std::string_view File) {
+  std::size_t Ext = File.rfind(".pkg.tar");
+  if (Ext == std::string_view::npos || File.ends_with(".sig")) return "";
+  std::string_view Name = File.substr(0, Ext);
+  // Drop pkgver, pkgrel and arch
+  for (int Field = 0; Field < 3; ++Field) {
+    std::size_t Dash = Name.rfind('-');
+    if (Dash == std::string_view::npos) return "";
+    Name = Name.substr(0, Dash);
+  }
+  return std::string(Name);
+}
+
+bool AurScheduler::start(const std::vector<PackageUpdate> &Pending, const std::string &Pass) {
+  if (Running || Pending.empty()) return false;
+  const Config &Cfg = getConfig();
+
+  Jobs.clear();
+  RepoDeps.clear();
+  InstallLog.clear();
+  Installing.clear();
+  InstallingDeps = false;
+  Cancelled = false;
+  MaxJobs = Cfg.AurJobs > 0 ? Cfg.AurJobs : std::max(1u, std::thread::hardware_concurrency());
+  // Only install steps get to use it, each through a helper that answers once
+  Password = Pass;
+
+  // The worker only gets copies, so nothing it reads is shared with the UI thread
+  Planning = std::async(std::launch::async, planJobs, Pending, Cfg.AurDepsCommand, MaxJobs);
+  Running = true;
+  return true;
+}
+
+AurPlan AurScheduler::planJobs(const std::vector<PackageUpdate> &Pending, const std::string &DepsCommand, int MaxJobs) {
+  AurPlan Plan;
+  std::vector<AurJob> &Jobs = Plan.Jobs;
+  std::vector<std::string> Cmds;
+  for (const PackageUpdate &Update : Pending) {
+    Cmds.push_back(expandPlaceholders(DepsCommand, {{"pkg", shellQuote(Update.Name)}}));
+  }
+  std::vector<std::string> Infos = executeCommands(Cmds, MaxJobs);
+
+  // "Field : value" lines; the base is named directly or is the file name of the snapshot
+  std::vector<std::string> Bases(Pending.size());
+  std::vector<std::vector<std::string>> PackageDeps(Pending.size());
+  for (std::size_t I = 0; I < Pending.size(); ++I) {
+    std::istringstream Stream(Infos[I]);
+    std::string Line;
+    while (std::getline(Stream, Line)) {
+      std::size_t Colon = Line.find(':');
+      if (Colon == std::string::npos) continue;
+      std::istringstream Fields(Line.substr(Colon + 1));
+      std::string Value;
+      if (Line.starts_with("Package Base ") || Line.starts_with("Base ")) {
+        Fields >> Bases[I];
+      } else if (Line.starts_with("Snapshot URL") && Bases[I].empty() && Fields >> Value && Value.ends_with(".tar.gz")) {
+        Bases[I] = fs::path(Value).filename().string();
+        Bases[I].resize(Bases[I].size() - std::string_view(".tar.gz").size());
+      } else if (Line.starts_with("Depends On") || Line.starts_with("Make Deps") || Line.starts_with("Check Deps")) {
+        while (Fields >> Value) {
+          if (Value != "None") PackageDeps[I].push_back(Value);
+        }
+      }
+    }
+    if (Bases[I].empty()) Bases[I] = Pending[I].Name;
+
+    auto It = std::ranges::find(Jobs, Bases[I], &AurJob::Name);
+    if (It == Jobs.end()) {
+      It = Jobs.emplace(Jobs.end());
+      It->Name = Bases[I];
+    }
+    It->Packages.push_back(Pending[I].Name);
+  }
+
+  // Edges between bases order the builds; everything else must come from the repos (or be installed already)
+  std::vector<std::string> Candidates;
+  for (std::size_t I = 0; I < Pending.size(); ++I) {
+    AurJob &Job = *std::ranges::find(Jobs, Bases[I], &AurJob::Name);
+    for (const std::string &Dep : PackageDeps[I]) {
+      std::string Name = stripVersion(Dep);
+      auto Owner = std::ranges::find_if(Pending, [&](const PackageUpdate &Update) { return Update.Name == Name; });
+      if (Owner == Pending.end()) {
+        if (std::ranges::find(Candidates, Dep) == Candidates.end()) Candidates.push_back(Dep);
+        continue;
+      }
+      const std::string &Base = Bases[Owner - Pending.begin()];
+      if (Base != Job.Name && std::ranges::find(Job.Deps, Base) == Job.Deps.end()) Job.Deps.push_back(Base);
+    }
+  }
+  if (Candidates.empty()) return Plan;
+
+  // pacman -T prints the dependencies that are not satisfied, versions and provides included
+  std::string Query = "pacman -T";
+  for (const std::string &Dep : Candidates) Query += ' ' + shellQuote(Dep);
+  std::istringstream Missing(executeCommand(Query.c_str()));
+  std::string Dep;
+  while (Missing >> Dep) Plan.RepoDeps.push_back(Dep);
+  return Plan;
+}
+
+bool AurScheduler::depsInstalled(const AurJob &Job) const {
+  return std::ranges::all_of(Job.Deps, [this](const std::string &Dep) {
+    auto It = std::ranges::find(Jobs, Dep, &AurJob::Name);
+    return It == Jobs.end() || It->State == BuildState::Installed;
+  });
+}
+
+void AurScheduler::skipDependents(const std::string &Name) {
+  for (AurJob &Job : Jobs) {
+    if (Job.State == BuildState::Waiting && std::ranges::find(Job.Deps, Name) != Job.Deps.end()) {
+      Job.State = BuildState::Skipped;
+      Job.Log.feed(std::format("Skipped: dependency {} failed\n", Name));
+      skipDependents(Job.Name);
+    }
+  }
+}
+
+bool AurScheduler::writeAskPass() {
+  // Same single-use helper as the main update: a second call finds the token and fails
+  char Template[] = "/tmp/imupdate_aurpass_XXXXXX";
+  int Fd = mkstemp(Template);
+  if (Fd < 0) return false;
+  std::string Script = std::format("#!/bin/sh\n"
+                                   "if [ -f \"{0}.used\" ]; then exit 1; fi\n"
+                                   "touch \"{0}.used\"\n"
+                                   "printf '%s\\n' \"$IMUPDATE_PASS\"\n",
+                                   Template);
+  bool Written = write(Fd, Script.data(), Script.size()) == static_cast<ssize_t>(Script.size());
+  fchmod(Fd, 0700);
+  close(Fd);
+  AskPassFile = Template;
+  if (!Written) removeAskPass();
+  return Written;
+}
+
+void AurScheduler::removeAskPass() {
+  if (AskPassFile.empty()) return;
+  std::error_code Ec;
+  fs::remove(AskPassFile, Ec);
+  fs::remove(AskPassFile + ".used", Ec);
+  AskPassFile.clear();
+}
+
+bool AurScheduler::spawnInstall(const std::string &Cmd) {
+  InstallLog.feed(std::format("\n$ {}\n", Cmd));
+  if (!writeAskPass()) {
+    InstallLog.feed("Could not create the password helper.\n");
+    return false;
+  }
+  if (!spawnPty(Cmd, InstallProc, {{"SUDO_ASKPASS", AskPassFile}, {"IMUPDATE_PASS", Password}}, &getConfig().Resources)) {
+    InstallLog.feed("Failed to execute install command via forkpty().\n");
+    removeAskPass();
+    return false;
+  }
+  return true;
+}
+
+void AurScheduler::launchRepoDeps() {
+  if (RepoDeps.empty()) return;
+  std::string Deps;
+  for (const std::string &Dep : RepoDeps) {
+    if (!Deps.empty()) Deps += ' ';
+    Deps += shellQuote(Dep);
+  }
+  // A failure is only reported; the builds that needed them fail on their own
+  InstallingDeps = spawnInstall(expandPlaceholders(getConfig().AurRepoDepsCommand, {{"deps", Deps}}));
+}
+
+void AurScheduler::launchBuilds() {
+  const Config &Cfg = getConfig();
+  int Building = static_cast<int>(std::ranges::count(Jobs, BuildState::Building, &AurJob::State));
+
+  for (AurJob &Job : Jobs) {
+    if (Building >= MaxJobs) break;
+    if (Job.State != BuildState::Waiting || !depsInstalled(Job)) continue;
+
+    std::string PkgDest = pkgDestDir(Job.Name);
+    std::error_code Ec;
+    fs::remove_all(PkgDest, Ec);
+    fs::create_directories(PkgDest, Ec);
+    fs::create_directories(buildDir(), Ec);
+
+    std::string Cmd = expandPlaceholders(Cfg.AurBuildCommand, {{"pkg", shellQuote(Job.Packages.front())},
+                                                               {"pkgbase", shellQuote(Job.Name)},
+                                                               {"builddir", shellQuote(buildDir())},
+                                                               {"pkgdest", shellQuote(PkgDest)}});
+    Job.Start = Clock::now();
+    if (spawnPty(Cmd, Job.Proc, {}, &Cfg.Resources)) {
+      Job.State = BuildState::Building;
+      Building++;
+    } else {
+      Job.State = BuildState::Failed;
+      Job.Log.feed("Failed to execute build command via forkpty().\n");
+      skipDependents(Job.Name);
+    }
+  }
+}
+
+void AurScheduler::launchInstall() {
+  // Everything built so far goes into one pacman transaction, so hooks run once per batch
+  std::string Files;
+  Installing.clear();
+  for (std::size_t I = 0; I < Jobs.size(); ++I) {
+    AurJob &Job = Jobs[I];
+    if (Job.State != BuildState::Built) continue;
+
+    // Only the pending packages of the base; split siblings and signatures stay behind
+    std::vector<std::string> JobFiles;
+    std::error_code Ec;
+    for (const fs::directory_entry &Entry : fs::directory_iterator(pkgDestDir(Job.Name), Ec)) {
+      std::string File = Entry.path().filename().string();
+      if (std::ranges::find(Job.Packages, packageFileName(File)) != Job.Packages.end()) {
+        JobFiles.push_back(shellQuote(Entry.path().string()));
+      }
+    }
+    if (JobFiles.size() != Job.Packages.size()) {
+      Job.State = BuildState::Failed;
+      Job.Log.feed("\n--- BUILD DID NOT PRODUCE EVERY PENDING PACKAGE ---\n");
+      skipDependents(Job.Name);
+      continue;
+    }
+    for (const std::string &File : JobFiles) {
+      if (!Files.empty()) Files += ' ';
+      Files += File;
+    }
+    Installing.push_back(I);
+  }
+  if (Installing.empty()) return;
+
+  bool Spawned = spawnInstall(expandPlaceholders(getConfig().AurInstallCommand, {{"files", Files}}));
+  for (std::size_t I : Installing) {
+    Jobs[I].State = Spawned ? BuildState::Installing : BuildState::Failed;
+  }
+  if (!Spawned) {
+    for (std::size_t I : Installing) skipDependents(Jobs[I].Name);
+    Installing.clear();
+  }
+}
+
+void AurScheduler::poll() {
+  if (!Running) return;
+
+  if (Planning.valid()) {
+    if (Planning.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+    AurPlan Plan = Planning.get();
+    Jobs = std::move(Plan.Jobs);
+    RepoDeps = std::move(Plan.RepoDeps);
+    if (!Cancelled) launchRepoDeps();
+  }
+
+  for (AurJob &Job : Jobs) {
+    if (Job.State != BuildState::Building) continue;
+    std::string Chunk;
+    PtyStatus Status = readPty(Job.Proc, Chunk);
+    Job.Log.feed(Chunk);
+    if (Status == PtyStatus::Running) continue;
+
+    int ExitStatus = closePty(Job.Proc);
+    Job.End = Clock::now();
+    if (ExitStatus == 0) {
+      Job.State = BuildState::Built;
+    } else {
+      Job.State = BuildState::Failed;
+      Job.Log.feed(std::format("\n--- BUILD FAILED (Exit Code: {}) ---\n", ExitStatus));
+      skipDependents(Job.Name);
+    }
+  }
+
+  if (InstallProc.active()) {
+    std::string Chunk;
+    PtyStatus Status = readPty(InstallProc, Chunk);
+    InstallLog.feed(Chunk);
+    if (Status != PtyStatus::Running) {
+      int ExitStatus = closePty(InstallProc);
+      removeAskPass();
+      if (InstallingDeps && ExitStatus != 0) {
+        InstallLog.feed(std::format("\n--- INSTALLING REPO DEPENDENCIES FAILED (Exit Code: {}) ---\n", ExitStatus));
+      }
+      InstallingDeps = false;
+      for (std::size_t I : Installing) {
+        Jobs[I].State = ExitStatus == 0 ? BuildState::Installed : BuildState::Failed;
+        if (ExitStatus != 0) skipDependents(Jobs[I].Name);
+      }
+      Installing.clear();
+    }
+  }
+
+  if (!Cancelled) {
+    if (!InstallProc.active()) launchInstall();
+    if (!InstallingDeps) launchBuilds();
+  }
+
+  // Nothing in flight and nothing startable: whatever still waits is part of a dependency cycle
+  bool Busy = InstallProc.active() || std::ranges::any_of(Jobs, [this](const AurJob &Job) {
+                return Job.State == BuildState::Building || (Job.State == BuildState::Built && !Cancelled);
+              });
+  if (!Busy) {
+    for (AurJob &Job : Jobs) {
+      if (Job.State == BuildState::Waiting || (Job.State == BuildState::Built && Cancelled)) {
+        Job.State = BuildState::Skipped;
+        Job.Log.feed(Cancelled ? "Skipped: cancelled\n" : "Skipped: unresolvable dependency cycle\n");
+      }
+    }
+    finish();
+  }
+}
+
+void AurScheduler::cancel() {
+  // Running builds are interrupted; poll() reaps them and then finishes. A running install is a
+  // pacman transaction and is left to complete, nothing is started after it. A plan still being
+  // worked out is waited for and then skipped entirely.
+  if (!Running) return;
+  Cancelled = true;
+  for (AurJob &Job : Jobs) {
+    if (Job.Proc.active()) stopPty(Job.Proc);
+  }
+}
+
+void AurScheduler::finish() {
+  Running = false;
+  // Don't keep the password around longer than needed
+  std::fill(Password.begin(), Password.end(), '\0');
+  Password.clear();
+  removeAskPass();
+}
+
+bool AurScheduler::succeeded() const {
+  return !Running && std::ranges::all_of(Jobs, [](const AurJob &Job) { return Job.State == BuildState::Installed; });
+}
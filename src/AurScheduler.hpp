@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Pty.hpp"
+#include "Terminal.hpp"
+#include "Transaction.hpp"
+#include "Updates.hpp"
+#include <future>
+#include <string>
+#include <vector>
+
+enum class BuildState { Waiting, Building, Built, Installing, Installed, Failed, Skipped };
+
+const char *buildStateName(BuildState State);
+
+// One build per package base, which may produce several of the pending packages
+struct AurJob {
+  std::string Name;                  // Package base
+  std::vector<std::string> Packages; // Pending packages it builds; other split packages aren't installed
+  std::vector<std::string> Deps;     // Bases of other pending AUR packages needed to build this one
+  BuildState State = BuildState::Waiting;
+  TerminalBuffer Log;
+  PtyProcess Proc;
+  Clock::time_point Start;
+  Clock::time_point End;
+};
+
+// Pending packages grouped into builds, and the repo dependencies none of them provide
+struct AurPlan {
+  std::vector<AurJob> Jobs;
+  std::vector<std::string> RepoDeps; // Dependencies pacman -T reported as missing
+};
+
+// Builds pending AUR updates concurrently, respecting their dependencies on each other,
+// and installs them in dependency order as the builds finish. Missing repo dependencies are
+// installed once before the first build, so pacman is only ever run by one step at a time;
+// builds never see the password. Looking the packages up takes network round trips, so the
+// plan is worked out on a worker thread that poll() picks up.
+class AurScheduler {
+public:
+  bool start(const std::vector<PackageUpdate> &Pending, const std::string &Password);
+  void poll();
+  void cancel();
+
+  bool running() const { return Running; }
+  bool planning() const { return Planning.valid(); }
+  bool cancelled() const { return Cancelled; }
+  bool succeeded() const;
+  const std::vector<AurJob> &jobs() const { return Jobs; }
+  const TerminalBuffer &installLog() const { return InstallLog; }
+
+private:
+  static AurPlan planJobs(const std::vector<PackageUpdate> &Pending, const std::string &DepsCommand, int MaxJobs);
+  bool depsInstalled(const AurJob &Job) const;
+  void skipDependents(const std::string &Name);
+  void launchRepoDeps();
+  void launchBuilds();
+  void launchInstall();
+  bool spawnInstall(const std::string &Cmd);
+  void finish();
+  bool writeAskPass();
+  void removeAskPass();
+
+  std::vector<AurJob> Jobs;
+  std::future<AurPlan> Planning;
+  std::vector<std::string> RepoDeps;
+  TerminalBuffer InstallLog;
+  PtyProcess InstallProc;
+  std::vector<std::size_t> Installing; // Jobs in the running install batch
+  bool InstallingDeps = false;         // The running install is the repo dependencies
+  std::string Password;
+  std::string AskPassFile; // Single-use helper of the running install step
+  int MaxJobs = 1;
+  bool Running = false;
+  bool Cancelled = false;
+};
@@ -0,0 +1,140 @@
+#include "Config.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+static std::string configPath() {
+  if (const char *Xdg = getenv("XDG_CONFIG_HOME"); Xdg && *Xdg) {
+    return std::format("{}/imupdate/config", Xdg);
+  }
+  if (const char *Home = getenv("HOME"); Home && *Home) {
+    return std::format("{}/.config/imupdate/config", Home);
+  }
+  return "";
+}
+
+static std::string_view trim(std::string_view Text) {
+  std::size_t First = Text.find_first_not_of(" \t\r");
+  if (First == std::string_view::npos) return {};
+  std::size_t Last = Text.find_last_not_of(" \t\r");
+  return Text.substr(First, Last - First + 1);
+}
+
+static bool parseBool(std::string_view Value) { return Value == "true" || Value == "yes" || Value == "on" || Value == "1"; }
+
+static int parseInt(std::string_view Value, int Fallback) {
+  int Result = Fallback;
+  auto [Ptr, Ec] = std::from_chars(Value.data(), Value.data() + Value.size(), Result);
+  return Ec == std::errc{} && Ptr == Value.data() + Value.size() ? Result : Fallback;
+}
+
+// Comma and/or whitespace separated values
+static std::vector<std::string> parseList(std::string_view Value) {
+  std::vector<std::string> Items;
+  std::size_t Pos = 0;
+  while (Pos < Value.size()) {
+    std::size_t End = Value.find_first_of(", \t", Pos);
+    if (End == std::string_view::npos) End = Value.size();
+    if (End > Pos) Items.emplace_back(Value.substr(Pos, End - Pos));
+    Pos = End + 1;
+  }
+  return Items;
+}
+
+static Config loadConfig() {
+  Config Cfg;
+  std::string Path = configPath();
+  std::ifstream File{fs::path(Path)};
+  if (!File.is_open()) {
+    return Cfg; // No config file: defaults
+  }
+
+  std::string Line;
+  while (std::getline(File, Line)) {
+    std::string_view Entry = trim(Line);
+    if (Entry.empty() || Entry.starts_with('#')) continue;
+    std::size_t Equals = Entry.find('=');
+    if (Equals == std::string_view::npos) {
+      std::cerr << std::format("{}: ignoring malformed line: {}\n", Path, Entry);
+      continue;
+    }
+    std::string_view Key = trim(Entry.substr(0, Equals));
+    std::string Value{trim(Entry.substr(Equals + 1))};
+
+    if (Key == "prefetch") {
+      Cfg.Prefetch = parseBool(Value);
+    } else if (Key == "prefetch_command") {
+      Cfg.PrefetchCommand = Value;
+    } else if (Key == "prefetch_rate") {
+      Cfg.PrefetchRate = Value;
+    } else if (Key == "aur_parallel") {
+      Cfg.AurParallel = parseBool(Value);
+    } else if (Key == "aur_jobs") {
+      Cfg.AurJobs = parseInt(Value, Cfg.AurJobs);
+    } else if (Key == "aur_deps_command") {
+      Cfg.AurDepsCommand = Value;
+    } else if (Key == "aur_repo_deps_command") {
+      Cfg.AurRepoDepsCommand = Value;
+    } else if (Key == "aur_build_command") {
+      Cfg.AurBuildCommand = Value;
+    } else if (Key == "aur_install_command") {
+      Cfg.AurInstallCommand = Value;
+    } else if (Key == "check_mirror") {
+      Cfg.CheckMirror = Value;
+    } else if (Key == "check_repos") {
+      Cfg.CheckRepos = parseList(Value);
+    } else if (Key == "check_timeout") {
+      Cfg.CheckTimeout = std::max(1, parseInt(Value, Cfg.CheckTimeout));
+    } else if (Key == "mirror_probe") {
+      Cfg.MirrorProbe = parseBool(Value);
+    } else if (Key == "mirrors") {
+      Cfg.Mirrors = parseList(Value);
+    } else if (Key == "mirrorlist") {
+      Cfg.MirrorList = Value;
+    } else if (Key == "mirror_probe_repo") {
+      Cfg.MirrorProbeRepo = Value;
+    } else if (Key == "mirror_probe_timeout") {
+      Cfg.MirrorProbeTimeout = std::max(1, parseInt(Value, Cfg.MirrorProbeTimeout));
+    } else if (Key == "mirror_probe_jobs") {
+      Cfg.MirrorProbeJobs = std::max(1, parseInt(Value, Cfg.MirrorProbeJobs));
+    } else if (Key == "fleet_timeout") {
+      Cfg.FleetTimeout = std::max(1, parseInt(Value, Cfg.FleetTimeout));
+    } else if (Key == "fleet_refresh") {
+      Cfg.FleetRefresh = std::max(1, parseInt(Value, Cfg.FleetRefresh));
+    } else if (Key == "serve_public") {
+      Cfg.ServePublic = parseBool(Value);
+    } else if (Key == "highlight_errors") {
+      Cfg.HighlightErrors = parseList(Value);
+    } else if (Key == "highlight_warnings") {
+      Cfg.HighlightWarnings = parseList(Value);
+    } else if (Key == "render_mode") {
+      Cfg.RenderMode = Value;
+    } else if (Key == "stream_fps") {
+      Cfg.StreamFps = std::clamp(parseInt(Value, Cfg.StreamFps), 1, 240);
+    } else if (Key == "nice") {
+      Cfg.Resources.Nice = std::clamp(parseInt(Value, Cfg.Resources.Nice), -20, 19);
+    } else if (Key == "ionice_class") {
+      Cfg.Resources.IoClass = std::clamp(parseInt(Value, Cfg.Resources.IoClass), 0, 3);
+    } else if (Key == "ionice_level") {
+      Cfg.Resources.IoLevel = std::clamp(parseInt(Value, Cfg.Resources.IoLevel), 0, 7);
+    } else if (Key == "cpu_quota") {
+      Cfg.Resources.CpuQuota = Value;
+    } else if (Key == "memory_max") {
+      Cfg.Resources.MemoryMax = Value;
+    } else {
+      std::cerr << std::format("{}: unknown key: {}\n", Path, Key);
+    }
+  }
+  return Cfg;
+}
+
+const Config &getConfig() {
+  static const Config Cfg = loadConfig();
+  return Cfg;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Resources.hpp"
+#include <string>
+#include <vector>
+
+// Settings read from $XDG_CONFIG_HOME/imupdate/config ("key = value" lines)
+struct Config {
+  // Background download of pending repo packages after a check
+  bool Prefetch = false;
+  std::string PrefetchCommand =
+      "ionice -c3 nice -n19 fakeroot -- pacman -Sw --noconfirm --dbpath {dbpath} --cachedir /var/cache/pacman/pkg "
+      "--cachedir {cachedir} --config {config} --logfile /dev/null";
+  std::string PrefetchRate = ""; // curl --limit-rate value, e.g. "500k"; empty means unlimited
+
+  // Build AUR updates ourselves, several at once, instead of one by one in paru
+  bool AurParallel = false;
+  int AurJobs = 0; // 0 means one per core
+  std::string AurDepsCommand = "paru -Si --aur {pkg}";
+  // Repo dependencies are installed once up front: concurrent "makepkg -s" would fight over the pacman lock
+  std::string AurRepoDepsCommand = "sudo -A pacman -S --needed --asdeps --noconfirm {deps}";
+  // Runs without access to the password; paru -G clones into a directory named after the pkgbase
+  std::string AurBuildCommand = "mkdir -p {builddir} && cd {builddir} && rm -rf {pkgbase} && paru -G {pkg} && cd {pkgbase} && "
+                                "PKGDEST={pkgdest} makepkg -f --noconfirm";
+  std::string AurInstallCommand = "sudo -A pacman -U --noconfirm {files}";
+
+  // Repo checks: where the sync DBs come from ($repo/$arch expanded) and how long a download may take
+  std::string CheckMirror = "";         // For mirrorlist repos; empty: the fastest probed mirror, or pacman's first server
+  std::vector<std::string> CheckRepos;  // Empty: the repos in pacman.conf
+  int CheckTimeout = 60;
+
+  // Probe mirrors after each check and put the fastest one first for prefetch and update
+  bool MirrorProbe = false;
+  std::vector<std::string> Mirrors; // Overrides the mirrorlist when set
+  std::string MirrorList = "/etc/pacman.d/mirrorlist";
+  std::string MirrorProbeRepo = "core"; // Its sync DB is what gets downloaded
+  int MirrorProbeTimeout = 5;           // Seconds per mirror
+  int MirrorProbeJobs = 8;
+
+  // Fleet view (-fleet): per-host timeout and how often all hosts are asked again, in seconds
+  int FleetTimeout = 10;
+  int FleetRefresh = 300;
+  // -serve may listen on every interface; the update list is handed to anyone who connects
+  bool ServePublic = false;
+
+  // Lines of the update log containing these are marked as errors/warnings
+  std::vector<std::string> HighlightErrors = {"error:", "ERROR:"};
+  std::vector<std::string> HighlightWarnings = {"warning:", "WARNING:", ".pacnew", ".pacsave"};
+
+  // "auto" (low-overhead on software GL), "low" or "full"; frame rate cap while an update streams
+  std::string RenderMode = "auto";
+  int StreamFps = 15;
+
+  // Applied to the update and AUR build process trees
+  ResourcePolicy Resources;
+};
+
+const Config &getConfig();
@@ -0,0 +1,358 @@
+#include "Fleet.hpp"
+#include "Config.hpp"
+#include "Socket.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <signal.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+using SteadyClock = std::chrono::steady_clock;
+
+// Request sent to every host, answered with its update list
+static constexpr std::string_view ListRequest = "list\n";
+// An update list is a few KiB; anything this large is not one
+static constexpr std::size_t MaxAnswerSize = 4 * 1024 * 1024;
+// Name lookups have no fd to wait on, so they are checked this often while any is running
+static constexpr int LookupPollMs = 10;
+// Clients -serve handles at once, and how long each may take to ask and read the answer
+static constexpr std::size_t MaxServeClients = 64;
+static constexpr std::chrono::seconds ServeTimeout{5};
+// A request is one short line
+static constexpr std::size_t MaxServeRequest = 64;
+
+const char *hostStateName(HostState State) {
+  switch (State) {
+  case HostState::Idle: return "idle";
+  case HostState::Resolving: return "resolving";
+  case HostState::Connecting: return "connecting";
+  case HostState::Sending: return "sending";
+  case HostState::Reading: return "reading";
+  case HostState::Done: return "ok";
+  case HostState::Failed: return "failed";
+  }
+  return "unknown";
+}
+
+std::vector<FleetHost> loadFleetHosts(const std::string &Path) {
+  std::vector<FleetHost> Hosts;
+  std::ifstream File(Path);
+  if (!File.is_open()) {
+    std::cerr << std::format("Error opening file: {}\n", Path);
+    return Hosts;
+  }
+  std::string Line;
+  while (std::getline(File, Line)) {
+    if (Line.starts_with('#')) continue;
+    std::istringstream Fields(Line);
+    std::string First, Second;
+    if (!(Fields >> First)) continue;
+    FleetHost &Host = Hosts.emplace_back();
+    Host.Name = First;
+    Host.Endpoint = Fields >> Second ? Second : First;
+  }
+  return Hosts;
+}
+
+FleetClient::~FleetClient() {
+  for (FleetHost &Host : Hosts) {
+    if (Host.Fd >= 0) close(Host.Fd);
+    // Waiting for a resolver stuck on a dead DNS server would hold up the exit
+    if (Host.Lookup && !Host.Lookup->cancel()) Host.Lookup.release();
+  }
+}
+
+void FleetClient::refresh() {
+  auto Deadline = SteadyClock::now() + std::chrono::seconds(getConfig().FleetTimeout);
+  for (FleetHost &Host : Hosts) {
+    if (Host.Fd >= 0 || Host.State == HostState::Resolving) continue; // Still answering the previous refresh
+    // A lookup that timed out may still be running; the host is asked again once it has ended
+    if (Host.Lookup && !Host.Lookup->cancel()) continue;
+    Host.Lookup.reset();
+    Host.Buffer.clear();
+    Host.Error.clear();
+    Host.Deadline = Deadline;
+    if (!isUnixAddress(Host.Endpoint)) {
+      Host.Lookup = std::make_unique<AddressLookup>(Host.Endpoint);
+      Host.State = HostState::Resolving;
+      continue;
+    }
+    Host.Fd = connectSocket(Host.Endpoint);
+    if (Host.Fd < 0) {
+      fail(Host, std::format("cannot connect: {}", strerror(errno)));
+      continue;
+    }
+    Host.State = HostState::Connecting;
+  }
+}
+
+bool FleetClient::busy() const {
+  return std::ranges::any_of(Hosts, [](const FleetHost &Host) { return Host.Fd >= 0 || Host.State == HostState::Resolving; });
+}
+
+bool FleetClient::pollLookups() {
+  bool Changed = false;
+  auto Now = SteadyClock::now();
+  for (FleetHost &Host : Hosts) {
+    if (Host.State != HostState::Resolving) continue;
+    int Error = Host.Lookup->error();
+    if (Error == EAI_INPROGRESS) {
+      if (Now >= Host.Deadline) {
+        if (Host.Lookup->cancel()) Host.Lookup.reset();
+        fail(Host, "timed out resolving");
+        Changed = true;
+      }
+      continue;
+    }
+    std::unique_ptr<AddressLookup> Lookup = std::move(Host.Lookup);
+    if (Error != 0) {
+      fail(Host, std::format("cannot resolve: {}", gai_strerror(Error)));
+      Changed = true;
+      continue;
+    }
+    Host.Fd = Lookup->connect();
+    if (Host.Fd < 0) {
+      fail(Host, std::format("cannot connect: {}", strerror(errno)));
+      Changed = true;
+      continue;
+    }
+    Host.State = HostState::Connecting;
+  }
+  return Changed;
+}
+
+void FleetClient::fail(FleetHost &Host, const std::string &Error) {
+  if (Host.Fd >= 0) close(Host.Fd);
+  Host.Fd = -1;
+  Host.State = HostState::Failed;
+  Host.Error = Error;
+}
+
+void FleetClient::complete(std::size_t Index) {
+  FleetHost &Host = Hosts[Index];
+  close(Host.Fd);
+  Host.Fd = -1;
+  Host.State = HostState::Done;
+  Host.Answered = SteadyClock::now();
+  Host.Updates = parseUpdateList(Host.Buffer);
+  Host.Buffer.clear();
+
+  // Only this host's rows change, the rest of the table stays as it is
+  for (auto It = Table.begin(); It != Table.end();) {
+    std::erase_if(It->second, [Index](const FleetEntry &Entry) { return Entry.Host == Index; });
+    It = It->second.empty() ? Table.erase(It) : std::next(It);
+  }
+  for (const PackageUpdate &Update : Host.Updates) {
+    Table[Update.Name].push_back({Index, Update.OldVersion, Update.NewVersion});
+  }
+}
+
+bool FleetClient::poll(int TimeoutMs) {
+  bool Changed = pollLookups();
+  std::vector<pollfd> Fds;
+  std::vector<std::size_t> Owners;
+  for (std::size_t I = 0; I < Hosts.size(); ++I) {
+    const FleetHost &Host = Hosts[I];
+    if (Host.Fd < 0) continue;
+    short Events = Host.State == HostState::Reading ? POLLIN : POLLOUT;
+    Fds.push_back({Host.Fd, Events, 0});
+    Owners.push_back(I);
+  }
+  bool Resolving = std::ranges::any_of(Hosts, [](const FleetHost &Host) { return Host.State == HostState::Resolving; });
+  if (Fds.empty() && !Resolving) return Changed;
+  if (Resolving) TimeoutMs = std::min(TimeoutMs, LookupPollMs);
+
+  // Don't sleep past the earliest deadline
+  auto Now = SteadyClock::now();
+  for (std::size_t I : Owners) {
+    auto Left = std::chrono::duration_cast<std::chrono::milliseconds>(Hosts[I].Deadline - Now).count();
+    TimeoutMs = static_cast<int>(std::clamp<long long>(Left, 0, TimeoutMs));
+  }
+  if (::poll(Fds.data(), Fds.size(), TimeoutMs) < 0 && errno != EINTR) return Changed;
+
+  std::array<char, 16 * 1024> Chunk;
+  for (std::size_t P = 0; P < Fds.size(); ++P) {
+    FleetHost &Host = Hosts[Owners[P]];
+    short Revents = Fds[P].revents;
+
+    if (Revents == 0) {
+      if (SteadyClock::now() >= Host.Deadline) {
+        fail(Host, "timed out");
+        Changed = true;
+      }
+      continue;
+    }
+
+    if (Host.State == HostState::Connecting) {
+      if (int Error = socketError(Host.Fd); Error != 0) {
+        fail(Host, std::format("cannot connect: {}", strerror(Error)));
+        Changed = true;
+        continue;
+      }
+      Host.State = HostState::Sending;
+    }
+
+    if (Host.State == HostState::Sending) {
+      // The request is tiny, a single send is all it takes
+      ssize_t Sent = send(Host.Fd, ListRequest.data(), ListRequest.size(), MSG_NOSIGNAL);
+      if (Sent != static_cast<ssize_t>(ListRequest.size())) {
+        fail(Host, "cannot send request");
+        Changed = true;
+        continue;
+      }
+      shutdown(Host.Fd, SHUT_WR);
+      Host.State = HostState::Reading;
+      continue;
+    }
+
+    // Reading until the host closes the connection
+    ssize_t BytesRead = read(Host.Fd, Chunk.data(), Chunk.size());
+    if (BytesRead > 0) {
+      Host.Buffer.append(Chunk.data(), BytesRead);
+      if (Host.Buffer.size() > MaxAnswerSize) {
+        fail(Host, "answer too large");
+        Changed = true;
+      }
+    } else if (BytesRead == 0) {
+      complete(Owners[P]);
+      Changed = true;
+    } else if (errno != EAGAIN && errno != EINTR) {
+      fail(Host, std::format("read error: {}", strerror(errno)));
+      Changed = true;
+    }
+  }
+  return Changed;
+}
+
+std::string summarizeVersions(const std::vector<FleetEntry> &Entries) {
+  std::map<std::string, int> Counts;
+  for (const FleetEntry &Entry : Entries) {
+    Counts[std::format("{} -> {}", Entry.OldVersion, Entry.NewVersion)]++;
+  }
+  std::string Summary;
+  for (const auto &[Versions, Count] : Counts) {
+    Summary += std::format("{}{} ({})", Summary.empty() ? "" : ", ", Versions, Count);
+  }
+  return Summary;
+}
+
+int printFleet(const std::string &HostsFile) {
+  FleetClient Fleet(loadFleetHosts(HostsFile));
+  Fleet.refresh();
+  while (Fleet.busy()) {
+    Fleet.poll(1000);
+  }
+  for (const auto &[Package, Entries] : Fleet.table()) {
+    std::cout << std::format("{} {} {}\n", Package, Entries.size(), summarizeVersions(Entries));
+  }
+  for (const FleetHost &Host : Fleet.hosts()) {
+    if (Host.State == HostState::Failed) {
+      std::cerr << std::format("{}: {}\n", Host.Name, Host.Error);
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+std::string defaultServeAddress() { return cacheDir() + "/list.sock"; }
+
+// A connection to serveUpdateList()
+struct ServeClient {
+  int Fd = -1;
+  std::string Request;
+  std::string Answer;
+  std::size_t Sent = 0;
+  bool Answering = false;
+  SteadyClock::time_point Deadline;
+};
+
+// Reads the request and starts the answer; false once the client is done with
+static bool readRequest(ServeClient &Client) {
+  std::array<char, 64> Buffer;
+  ssize_t BytesRead = read(Client.Fd, Buffer.data(), Buffer.size());
+  if (BytesRead < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+  if (BytesRead == 0) return false;
+  Client.Request.append(Buffer.data(), BytesRead);
+  if (Client.Request.find('\n') == std::string::npos && Client.Request.size() < MaxServeRequest) return true;
+  if (!Client.Request.starts_with("list")) return false;
+  std::error_code Ec;
+  Client.Answer = fs::exists("/tmp/updates_list", Ec) ? readFile("/tmp/updates_list") : "";
+  Client.Answering = true;
+  return !Client.Answer.empty();
+}
+
+// Sends what the socket takes; false once everything is out or the client is gone
+static bool writeAnswer(ServeClient &Client) {
+  ssize_t Written = write(Client.Fd, Client.Answer.data() + Client.Sent, Client.Answer.size() - Client.Sent);
+  if (Written < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+  Client.Sent += Written;
+  return Client.Sent < Client.Answer.size();
+}
+
+int serveUpdateList(const std::string &Address) {
+  if (isWildcardAddress(Address) && !getConfig().ServePublic) {
+    std::cerr << std::format("Refusing to serve the update list on every interface ({}); set serve_public = true to allow "
+                             "it, or listen on a UNIX socket or a single address\n",
+                             Address);
+    return EXIT_FAILURE;
+  }
+  int Listener = listenSocket(Address);
+  if (Listener < 0) {
+    std::cerr << std::format("Cannot listen on {}: {}\n", Address, strerror(errno));
+    return EXIT_FAILURE;
+  }
+  fcntl(Listener, F_SETFL, fcntl(Listener, F_GETFL) | O_NONBLOCK);
+  signal(SIGPIPE, SIG_IGN);
+
+  // Same model as the fleet client: one thread, non-blocking sockets and poll(), so a slow
+  // client only ever holds up itself until its deadline
+  std::vector<ServeClient> Clients;
+  std::vector<pollfd> Fds;
+  while (true) {
+    SteadyClock::time_point Now = SteadyClock::now();
+    Fds.assign(1, {Listener, static_cast<short>(Clients.size() < MaxServeClients ? POLLIN : 0), 0});
+    int TimeoutMs = -1;
+    for (const ServeClient &Client : Clients) {
+      Fds.push_back({Client.Fd, static_cast<short>(Client.Answering ? POLLOUT : POLLIN), 0});
+      auto Left = std::chrono::ceil<std::chrono::milliseconds>(Client.Deadline - Now).count();
+      int Ms = static_cast<int>(std::max<decltype(Left)>(0, Left));
+      TimeoutMs = TimeoutMs < 0 ? Ms : std::min(TimeoutMs, Ms);
+    }
+    if (::poll(Fds.data(), Fds.size(), TimeoutMs) < 0 && errno != EINTR) break;
+
+    Now = SteadyClock::now();
+    for (std::size_t I = Clients.size(); I-- > 0;) {
+      ServeClient &Client = Clients[I];
+      short Events = Fds[I + 1].revents;
+      bool Open = Now < Client.Deadline && !(Events & (POLLERR | POLLNVAL));
+      if (Open && !Client.Answering && (Events & (POLLIN | POLLHUP))) Open = readRequest(Client);
+      if (Open && Client.Answering && ((Events & POLLOUT) || Client.Sent == 0)) Open = writeAnswer(Client);
+      if (!Open) {
+        close(Client.Fd);
+        Clients.erase(Clients.begin() + I);
+      }
+    }
+
+    if (Fds[0].revents & POLLIN) {
+      while (Clients.size() < MaxServeClients) {
+        int Fd = accept4(Listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (Fd < 0) break;
+        Clients.push_back({.Fd = Fd, .Deadline = Now + ServeTimeout});
+      }
+    }
+  }
+  for (const ServeClient &Client : Clients) close(Client.Fd);
+  close(Listener);
+  return EXIT_FAILURE;
+}
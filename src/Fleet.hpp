@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Socket.hpp"
+#include "Updates.hpp"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class HostState { Idle, Resolving, Connecting, Sending, Reading, Done, Failed };
+
+const char *hostStateName(HostState State);
+
+struct FleetHost {
+  std::string Name;
+  std::string Endpoint;
+  HostState State = HostState::Idle;
+  std::string Error;
+  std::vector<PackageUpdate> Updates; // From the last successful answer
+  std::chrono::steady_clock::time_point Answered;
+
+  // Connection in flight
+  std::unique_ptr<AddressLookup> Lookup; // Host names are resolved before connecting
+  int Fd = -1;
+  std::string Buffer;
+  std::chrono::steady_clock::time_point Deadline;
+};
+
+// One host's version of a pending package
+struct FleetEntry {
+  std::size_t Host;
+  std::string OldVersion;
+  std::string NewVersion;
+};
+
+// Talks to many hosts from a single thread with non-blocking sockets and poll()
+class FleetClient {
+public:
+  explicit FleetClient(std::vector<FleetHost> FleetHosts) : Hosts(std::move(FleetHosts)) {}
+  ~FleetClient();
+
+  void refresh();
+  // Handles whatever is ready within TimeoutMs; returns true when the table changed
+  bool poll(int TimeoutMs);
+  bool busy() const;
+
+  const std::vector<FleetHost> &hosts() const { return Hosts; }
+  // Package name -> hosts that have an update for it, sorted by package
+  const std::map<std::string, std::vector<FleetEntry>> &table() const { return Table; }
+
+private:
+  bool pollLookups();
+  void fail(FleetHost &Host, const std::string &Error);
+  void complete(std::size_t Index);
+
+  std::vector<FleetHost> Hosts;
+  std::map<std::string, std::vector<FleetEntry>> Table;
+};
+
+// "6.1-1 -> 6.2-1 (12), 6.0-1 -> 6.2-1 (3)"
+std::string summarizeVersions(const std::vector<FleetEntry> &Entries);
+// Waits for every host and prints the merged table
+int printFleet(const std::string &HostsFile);
+
+// "<endpoint>" or "<name> <endpoint>" per line
+std::vector<FleetHost> loadFleetHosts(const std::string &Path);
+// UNIX socket in the cache dir, only reachable by this user
+std::string defaultServeAddress();
+// Answers "list" requests with the last update list, forever
+int serveUpdateList(const std::string &Address);
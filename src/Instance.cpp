@@ -0,0 +1,90 @@
+#include "Instance.hpp"
+#include "Socket.hpp"
+#include <array>
+#include <fcntl.h>
+#include <format>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static int g_InstanceFd = -1;
+
+std::string instanceAddress() { return std::format("@imupdate-{}", getuid()); }
+
+// Abstract sockets have no permissions, so both ends check who is on the other side
+static bool peerIsUs(int Fd) {
+  ucred Cred;
+  socklen_t Len = sizeof(Cred);
+  return getsockopt(Fd, SOL_SOCKET, SO_PEERCRED, &Cred, &Len) == 0 && Cred.uid == getuid();
+}
+
+std::optional<std::string> sendToInstance(std::string_view Request) {
+  int Fd = connectSocket(instanceAddress());
+  if (Fd < 0) return std::nullopt; // Nobody is listening
+
+  pollfd Poll = {Fd, POLLOUT, 0};
+  std::string Message = std::format("{}\n", Request);
+  if (poll(&Poll, 1, 1000) != 1 || socketError(Fd) != 0 || !peerIsUs(Fd) ||
+      send(Fd, Message.data(), Message.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(Message.size())) {
+    close(Fd);
+    return std::nullopt;
+  }
+  shutdown(Fd, SHUT_WR);
+
+  // A reply cut short is still a reply; none at all means the request was dropped
+  std::string Reply;
+  std::array<char, 256> Buffer;
+  Poll.events = POLLIN;
+  while (poll(&Poll, 1, 5000) == 1) {
+    ssize_t BytesRead = read(Fd, Buffer.data(), Buffer.size());
+    if (BytesRead <= 0) break;
+    Reply.append(Buffer.data(), BytesRead);
+  }
+  close(Fd);
+  // Every request gets a non-empty reply, so an empty one was never handled
+  if (Reply.empty()) return std::nullopt;
+  return Reply;
+}
+
+bool claimInstance() {
+  if (g_InstanceFd >= 0) return true;
+  int Fd = listenSocket(instanceAddress());
+  if (Fd < 0) return false;
+  fcntl(Fd, F_SETFL, fcntl(Fd, F_GETFL) | O_NONBLOCK);
+  g_InstanceFd = Fd;
+  return true;
+}
+
+void releaseInstance() {
+  if (g_InstanceFd < 0) return;
+  close(g_InstanceFd);
+  g_InstanceFd = -1;
+}
+
+void pollInstance(const std::function<std::string(std::string_view)> &Handle) {
+  if (g_InstanceFd < 0) return;
+  while (true) {
+    int Client = accept4(g_InstanceFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (Client < 0) return; // Nothing pending
+    if (!peerIsUs(Client)) {
+      close(Client);
+      continue;
+    }
+
+    // Clients send their request right after connecting; a silent one must not stall the GUI
+    timeval Timeout = {0, 200000};
+    setsockopt(Client, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout));
+    setsockopt(Client, SOL_SOCKET, SO_SNDTIMEO, &Timeout, sizeof(Timeout));
+
+    std::array<char, 64> Request;
+    ssize_t BytesRead = read(Client, Request.data(), Request.size());
+    if (BytesRead > 0) {
+      std::string_view Text(Request.data(), BytesRead);
+      if (Text.ends_with('\n')) Text.remove_suffix(1);
+      std::string Reply = Handle(Text);
+      send(Client, Reply.data(), Reply.size(), MSG_NOSIGNAL);
+    }
+    close(Client);
+  }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// One imupdate GUI per user. Later launches hand their request ("show", "refresh", "count", "ping")
+// to it over an abstract UNIX socket, which goes away with the process, so nothing is left stale.
+std::string instanceAddress();
+// The running instance's reply, or nothing when no instance of this user took the request.
+// An instance that is shutting down may accept the connection without answering; that counts as none.
+std::optional<std::string> sendToInstance(std::string_view Request);
+// Takes the per-user address for this process; false if another instance holds it
+bool claimInstance();
+// Gives the address up again, so later launches stop handing their requests to this process
+void releaseInstance();
+// Answers pending requests without blocking; Handle returns the reply to each one
+void pollInstance(const std::function<std::string(std::string_view)> &Handle);
@@ -0,0 +1,166 @@
+#include "LogIndex.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void findAll(std::string_view Text, std::string_view Needle, std::size_t Base, std::vector<std::size_t> &Out) {
+  const std::size_t Size = Needle.size();
+  if (Size == 0 || Text.size() < Size) return;
+  const std::size_t LastStart = Text.size() - Size;
+  std::size_t Pos = 0;
+
+#if defined(__SSE2__)
+  // Test 16 candidate starts at once against the needle's first and last byte;
+  // only where both agree are the bytes in between compared
+  const __m128i First = _mm_set1_epi8(Needle.front());
+  const __m128i Last = _mm_set1_epi8(Needle.back());
+  for (; Pos + 15 <= LastStart; Pos += 16) {
+    __m128i Head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Text.data() + Pos));
+    __m128i Tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Text.data() + Pos + Size - 1));
+    unsigned Mask = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(Head, First), _mm_cmpeq_epi8(Tail, Last))));
+    while (Mask) {
+      std::size_t Start = Pos + std::countr_zero(Mask);
+      if (Size <= 2 || std::memcmp(Text.data() + Start + 1, Needle.data() + 1, Size - 2) == 0) {
+        Out.push_back(Base + Start);
+      }
+      Mask &= Mask - 1;
+    }
+  }
+#endif
+
+  // Whatever is left (or everything, without SSE2)
+  while ((Pos = Text.find(Needle, Pos)) != std::string_view::npos) {
+    Out.push_back(Base + Pos);
+    ++Pos;
+  }
+}
+
+LogIndex::LogIndex(const TerminalBuffer &Buffer, std::vector<std::string> ErrorPatterns,
+                   std::vector<std::string> WarningPatterns)
+    : Buffer(Buffer), ErrorPatterns(std::move(ErrorPatterns)), WarningPatterns(std::move(WarningPatterns)),
+      Generation(Buffer.generation()) {}
+
+void LogIndex::reset() {
+  Indexed = 0;
+  LineStarts.assign(1, 0);
+  LongestLine = 0;
+  ErrorLines.clear();
+  WarningLines.clear();
+  // The query stays, its matches are found again in the new text
+  for (Refinement &Step : Refinements) {
+    Step.Matches.clear();
+    Step.ScannedTo = 0;
+  }
+}
+
+void LogIndex::rollback(std::size_t Offset) {
+  // Lines from the one starting at Offset on may have been rewritten; they are indexed again
+  // once they are finished. Everything is sorted, so this only trims the tails.
+  std::size_t Line = lineOf(Offset);
+  LineStarts.resize(Line + 1);
+  for (std::vector<std::size_t> *Lines : {&ErrorLines, &WarningLines}) {
+    Lines->erase(std::ranges::lower_bound(*Lines, Line), Lines->end());
+  }
+  for (Refinement &Step : Refinements) {
+    Step.Matches.erase(std::ranges::lower_bound(Step.Matches, Offset), Step.Matches.end());
+    Step.ScannedTo = std::min(Step.ScannedTo, Offset);
+  }
+  Indexed = Offset;
+}
+
+void LogIndex::catchUp(Refinement &Step) {
+  // Committed text always ends on a line break and queries have none, so no match spans the seam
+  std::string_view Text = Buffer.text();
+  findAll(Text.substr(Step.ScannedTo, Indexed - Step.ScannedTo), Step.Query, Step.ScannedTo, Step.Matches);
+  Step.ScannedTo = Indexed;
+}
+
+void LogIndex::update() {
+  if (Buffer.generation() != Generation) {
+    Generation = Buffer.generation();
+    reset();
+  } else if (Buffer.rewinds() != Rewinds) {
+    // Whatever was rewritten since the last update was on the screen back then
+    rollback(std::min(Indexed, ScreenStart));
+  }
+  Rewinds = Buffer.rewinds();
+  ScreenStart = Buffer.screenStart();
+  std::size_t Committed = Buffer.committedSize();
+  if (Committed == Indexed) return;
+
+  std::string_view Chunk = std::string_view(Buffer.text()).substr(Indexed, Committed - Indexed);
+  for (std::size_t Pos = 0; (Pos = Chunk.find('\n', Pos)) != std::string_view::npos; ++Pos) {
+    LongestLine = std::max(LongestLine, Indexed + Pos - LineStarts.back());
+    LineStarts.push_back(Indexed + Pos + 1);
+  }
+
+  // Pattern hits of the chunk, as line numbers in order and without repeats
+  auto IndexPatterns = [&](const std::vector<std::string> &Patterns, std::vector<std::size_t> &Lines) {
+    std::vector<std::size_t> Hits;
+    for (const std::string &Pattern : Patterns) findAll(Chunk, Pattern, Indexed, Hits);
+    if (Hits.empty()) return;
+    for (std::size_t &Hit : Hits) Hit = lineOf(Hit);
+    std::ranges::sort(Hits);
+    for (std::size_t Line : Hits) {
+      if (Lines.empty() || Lines.back() != Line) Lines.push_back(Line);
+    }
+  };
+  IndexPatterns(ErrorPatterns, ErrorLines);
+  IndexPatterns(WarningPatterns, WarningLines);
+
+  Indexed = Committed;
+  if (!Refinements.empty()) catchUp(Refinements.back());
+}
+
+void LogIndex::setQuery(std::string_view Query) {
+  if (!Refinements.empty() && Refinements.back().Query == Query) return;
+
+  // Back to the longest earlier step this query still extends
+  while (!Refinements.empty() && !Query.starts_with(Refinements.back().Query)) Refinements.pop_back();
+  if (Query.empty()) return;
+
+  if (Refinements.empty()) {
+    Refinements.push_back({std::string(Query), {}, 0});
+    catchUp(Refinements.back());
+    return;
+  }
+
+  Refinement &Previous = Refinements.back();
+  catchUp(Previous);
+  if (Previous.Query == Query) return;
+
+  // Every match of the longer query starts where the shorter one matched
+  std::string_view Text = Buffer.text();
+  Refinement Next{std::string(Query), {}, Previous.ScannedTo};
+  for (std::size_t Offset : Previous.Matches) {
+    if (Text.substr(Offset, Query.size()) == Query) Next.Matches.push_back(Offset);
+  }
+  Refinements.push_back(std::move(Next));
+}
+
+const std::string &LogIndex::query() const {
+  static const std::string None;
+  return Refinements.empty() ? None : Refinements.back().Query;
+}
+
+const std::vector<std::size_t> &LogIndex::matches() const {
+  static const std::vector<std::size_t> None;
+  return Refinements.empty() ? None : Refinements.back().Matches;
+}
+
+const std::vector<std::size_t> &LogIndex::lines(Severity Level) const {
+  return Level == Severity::Error ? ErrorLines : WarningLines;
+}
+
+std::size_t LogIndex::lineStart(std::size_t Line) const {
+  return Line < LineStarts.size() ? LineStarts[Line] : Buffer.text().size();
+}
+
+std::size_t LogIndex::lineOf(std::size_t Offset) const {
+  return std::upper_bound(LineStarts.begin(), LineStarts.end(), Offset) - LineStarts.begin() - 1;
+}
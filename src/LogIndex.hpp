@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Terminal.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class Severity { Warning, Error };
+
+// Appends the offset of every (possibly overlapping) occurrence of Needle in Text, plus Base
+void findAll(std::string_view Text, std::string_view Needle, std::size_t Base, std::vector<std::size_t> &Out);
+
+// Search and severity index over the committed lines of a TerminalBuffer.
+// Only newly committed text is scanned on update(); a clear() of the buffer starts over, and
+// lines the cursor may have moved back into are scanned again once they are committed.
+class LogIndex {
+public:
+  LogIndex(const TerminalBuffer &Buffer, std::vector<std::string> ErrorPatterns, std::vector<std::string> WarningPatterns);
+
+  void update();
+  // Case-sensitive; a query that extends the previous one only filters its matches
+  void setQuery(std::string_view Query);
+
+  const std::string &query() const;
+  // Byte offsets of the current query's matches, ascending
+  const std::vector<std::size_t> &matches() const;
+  // Lines containing one of the patterns of that severity, ascending
+  const std::vector<std::size_t> &lines(Severity Level) const;
+
+  // Committed lines plus the one still being written
+  std::size_t lineCount() const { return LineStarts.size(); }
+  std::size_t lineStart(std::size_t Line) const;
+  std::size_t lineOf(std::size_t Offset) const;
+  std::size_t longestLine() const { return LongestLine; }
+
+private:
+  // One step of a query being typed; earlier steps are kept so backspace is free too
+  struct Refinement {
+    std::string Query;
+    std::vector<std::size_t> Matches;
+    std::size_t ScannedTo = 0;
+  };
+
+  void reset();
+  void rollback(std::size_t Offset);
+  void catchUp(Refinement &Step);
+
+  const TerminalBuffer &Buffer;
+  std::vector<std::string> ErrorPatterns;
+  std::vector<std::string> WarningPatterns;
+
+  std::size_t Generation = 0;
+  std::size_t Rewinds = 0;     // Of the buffer, as of the last update
+  std::size_t ScreenStart = 0; // Nothing before it can have changed since the last update
+  std::size_t Indexed = 0;
+  std::vector<std::size_t> LineStarts{0};
+  std::size_t LongestLine = 0;
+  std::vector<std::size_t> ErrorLines;
+  std::vector<std::size_t> WarningLines;
+  std::vector<Refinement> Refinements;
+};
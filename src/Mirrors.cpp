@@ -0,0 +1,151 @@
+#include "Mirrors.hpp"
+#include "Config.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/utsname.h>
+
+// Older results lose half of their weight every day
+static constexpr double HistoryHalfLife = 24 * 3600.0;
+// Ranking assumes a download of this size: both latency and throughput matter
+static constexpr double ReferenceBytes = 8.0 * 1024 * 1024;
+
+static std::string historyPath() { return cacheDir() + "/mirrors"; }
+
+static long long unixNow() {
+  return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Estimated seconds to fetch ReferenceBytes; lower is better
+static double score(const MirrorStats &Stats) {
+  if (Stats.Throughput <= 0) return HUGE_VAL;
+  return Stats.Latency + ReferenceBytes / Stats.Throughput;
+}
+
+const std::string &pacmanArchitecture() {
+  static const std::string Arch = [] {
+    std::istringstream Output(executeCommand("pacman-conf Architecture"));
+    std::string Value;
+    if (Output >> Value && Value != "auto") return Value;
+    utsname Info;
+    return std::string(uname(&Info) == 0 ? Info.machine : "x86_64");
+  }();
+  return Arch;
+}
+
+std::string expandServer(std::string_view Template, std::string_view Repo) {
+  std::string Server(Template);
+  for (auto [Name, Value] : {std::pair<std::string_view, std::string_view>{"$repo", Repo}, {"$arch", pacmanArchitecture()}}) {
+    for (std::size_t Pos = 0; (Pos = Server.find(Name, Pos)) != std::string::npos; Pos += Value.size()) {
+      Server.replace(Pos, Name.size(), Value);
+    }
+  }
+  return Server;
+}
+
+std::vector<std::string> configuredMirrors() {
+  const Config &Cfg = getConfig();
+  if (!Cfg.Mirrors.empty()) {
+    return Cfg.Mirrors;
+  }
+  // "Server = https://.../$repo/os/$arch" lines of the mirrorlist, in order
+  std::vector<std::string> Mirrors;
+  std::ifstream File(Cfg.MirrorList);
+  std::string Line;
+  while (std::getline(File, Line)) {
+    std::istringstream Fields(Line);
+    std::string Key, Equals, Url;
+    if (Fields >> Key >> Equals >> Url && Key == "Server" && Equals == "=") {
+      Mirrors.push_back(Url);
+    }
+  }
+  return Mirrors;
+}
+
+static std::vector<MirrorStats> loadHistory() {
+  std::vector<MirrorStats> History;
+  std::ifstream File(historyPath());
+  MirrorStats Stats;
+  while (File >> Stats.Url >> Stats.Latency >> Stats.Throughput >> Stats.Probed) {
+    History.push_back(Stats);
+  }
+  return History;
+}
+
+static void saveHistory(const std::vector<MirrorStats> &History) {
+  // Probes run in the background, so readers must never see a half written file
+  std::string Temp = historyPath() + ".tmp";
+  {
+    std::ofstream File(Temp);
+    for (const MirrorStats &Stats : History) {
+      File << std::format("{} {:.4f} {:.0f} {}\n", Stats.Url, Stats.Latency, Stats.Throughput, Stats.Probed);
+    }
+  }
+  std::error_code Ec;
+  std::filesystem::rename(Temp, historyPath(), Ec);
+}
+
+void probeMirrors(bool Debug) {
+  const Config &Cfg = getConfig();
+  std::vector<std::string> Mirrors = configuredMirrors();
+  if (Mirrors.empty()) return;
+
+  std::vector<std::string> Cmds;
+  for (const std::string &Mirror : Mirrors) {
+    std::string Url = expandServer(Mirror, Cfg.MirrorProbeRepo);
+    Cmds.push_back(std::format("curl -s -o /dev/null --max-time {} -w '%{{http_code}} %{{time_starttransfer}} %{{speed_download}}' {}",
+                               Cfg.MirrorProbeTimeout, shellQuote(std::format("{}/{}.db", Url, Cfg.MirrorProbeRepo))));
+  }
+  std::vector<std::string> Results = executeCommands(Cmds, Cfg.MirrorProbeJobs, Debug);
+
+  std::vector<MirrorStats> History = loadHistory();
+  long long Now = unixNow();
+  for (std::size_t I = 0; I < Mirrors.size(); ++I) {
+    MirrorStats Fresh{Mirrors[I], 0, 0, Now};
+    std::istringstream Fields(Results[I]);
+    int HttpCode = 0;
+    Fields >> HttpCode >> Fresh.Latency >> Fresh.Throughput;
+    if (HttpCode != 200) {
+      // Failures and timeouts count as a dead mirror for this round
+      Fresh.Latency = Cfg.MirrorProbeTimeout;
+      Fresh.Throughput = 0;
+    }
+    if (Debug) {
+      std::cerr << std::format("mirror {}: http {} latency {:.3f}s {:.0f} B/s\n", Mirrors[I], HttpCode, Fresh.Latency, Fresh.Throughput);
+    }
+
+    auto It = std::ranges::find(History, Mirrors[I], &MirrorStats::Url);
+    if (It == History.end()) {
+      History.push_back(Fresh);
+      continue;
+    }
+    // The older the previous result, the less it counts against the new one
+    double Weight = 0.5 * std::exp2(-static_cast<double>(Now - It->Probed) / HistoryHalfLife);
+    It->Latency = Weight * It->Latency + (1.0 - Weight) * Fresh.Latency;
+    It->Throughput = Weight * It->Throughput + (1.0 - Weight) * Fresh.Throughput;
+    It->Probed = Now;
+  }
+  saveHistory(History);
+}
+
+std::vector<MirrorStats> rankedMirrors() {
+  std::vector<std::string> Mirrors = configuredMirrors();
+  std::vector<MirrorStats> Ranked;
+  for (const MirrorStats &Stats : loadHistory()) {
+    if (std::ranges::find(Mirrors, Stats.Url) != Mirrors.end()) Ranked.push_back(Stats);
+  }
+  std::ranges::sort(Ranked, {}, score);
+  return Ranked;
+}
+
+std::string bestMirror() {
+  std::vector<MirrorStats> Ranked = rankedMirrors();
+  if (Ranked.empty() || Ranked.front().Throughput <= 0) return "";
+  return Ranked.front().Url;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct MirrorStats {
+  std::string Url;      // Server template as in the mirrorlist ($repo/$arch)
+  double Latency = 0;   // Seconds until the first byte
+  double Throughput = 0; // Bytes per second, 0 when the probe failed
+  long long Probed = 0; // Unix time of the last probe
+};
+
+// Architecture pacman substitutes for $arch
+const std::string &pacmanArchitecture();
+// A mirrorlist "Server" template with $repo and $arch filled in
+std::string expandServer(std::string_view Template, std::string_view Repo);
+
+std::vector<std::string> configuredMirrors();
+// Fetches a small sync DB from every mirror concurrently and folds the results into the history.
+// Takes up to the probe timeout per batch of mirrors, so it never runs as part of a check.
+void probeMirrors(bool Debug = false);
+std::vector<MirrorStats> rankedMirrors();
+// Best configured mirror from the history, or empty if nothing has been probed yet
+std::string bestMirror();
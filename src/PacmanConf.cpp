@@ -0,0 +1,76 @@
+#include "PacmanConf.hpp"
+#include "Config.hpp"
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+static constexpr const char *SystemPacmanConf = "/etc/pacman.conf";
+
+// "Include = /etc/pacman.d/mirrorlist", with Entry already stripped of leading blanks.
+// Only the configured mirrorlist counts: third-party lists (e.g. chaotic-mirrorlist) keep their servers.
+static bool includesMirrorList(std::string_view Entry) {
+  if (!Entry.starts_with("Include")) return false;
+  std::size_t Equals = Entry.find('=');
+  if (Equals == std::string_view::npos) return false;
+  std::string_view Target = Entry.substr(Equals + 1);
+  Target.remove_prefix(std::min(Target.size(), Target.find_first_not_of(" \t")));
+  Target = Target.substr(0, Target.find_last_not_of(" \t\r") + 1);
+  return Target == getConfig().MirrorList;
+}
+
+std::string writePacmanConf(const std::string &Path, const PacmanConfOverrides &Overrides) {
+  if (Overrides.XferCommand.empty() && Overrides.Server.empty()) {
+    return SystemPacmanConf;
+  }
+  std::ifstream In(SystemPacmanConf);
+  std::ofstream Out(Path);
+  if (!In.is_open() || !Out.is_open()) {
+    std::cerr << std::format("Could not write pacman config to {}\n", Path);
+    return SystemPacmanConf;
+  }
+
+  // Our options go at the end of [options] so they win over earlier ones
+  std::string Line;
+  bool InOptions = false;
+  auto EmitOptions = [&]() {
+    if (!Overrides.XferCommand.empty()) Out << std::format("XferCommand = {}\n", Overrides.XferCommand);
+  };
+  while (std::getline(In, Line)) {
+    bool Section = Line.starts_with('[');
+    if (Section && InOptions) {
+      EmitOptions();
+      InOptions = false;
+    }
+    if (Section) InOptions = Line.starts_with("[options]");
+
+    // Servers are tried in order, so ours goes in front of the mirrorlist
+    std::string_view Entry = Line;
+    Entry.remove_prefix(std::min(Entry.size(), Entry.find_first_not_of(" \t")));
+    if (!InOptions && !Overrides.Server.empty() && includesMirrorList(Entry)) {
+      Out << std::format("Server = {}\n", Overrides.Server);
+    }
+    Out << Line << '\n';
+  }
+  if (InOptions) EmitOptions();
+  return Path;
+}
+
+std::vector<std::string> mirrorListRepos() {
+  std::vector<std::string> Repos;
+  std::ifstream In(SystemPacmanConf);
+  std::string Line;
+  std::string Section;
+  while (std::getline(In, Line)) {
+    std::string_view Entry = Line;
+    Entry.remove_prefix(std::min(Entry.size(), Entry.find_first_not_of(" \t")));
+    if (Entry.starts_with('[')) {
+      Section = Entry.substr(1, Entry.find(']') - 1);
+    } else if (!Section.empty() && Section != "options" && includesMirrorList(Entry) &&
+               std::ranges::find(Repos, Section) == Repos.end()) {
+      Repos.push_back(Section);
+    }
+  }
+  return Repos;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct PacmanConfOverrides {
+  std::string XferCommand; // Replaces the download command when set
+  std::string Server;      // Tried first by every repo that uses the mirrorlist
+};
+
+// Writes a copy of /etc/pacman.conf with the overrides applied to Path and
+// returns the config to use (the system one when there is nothing to override)
+std::string writePacmanConf(const std::string &Path, const PacmanConfOverrides &Overrides);
+
+// Repos whose servers come from the configured mirrorlist, i.e. the ones a probed mirror may stand in for
+std::vector<std::string> mirrorListRepos();
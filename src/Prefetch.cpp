@@ -0,0 +1,79 @@
+#include "Prefetch.hpp"
+#include "Config.hpp"
+#include "Mirrors.hpp"
+#include "PacmanConf.hpp"
+#include "SyncDb.hpp"
+#include "Updates.hpp"
+#include "Utils.hpp"
+#include <array>
+#include <filesystem>
+#include <format>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static constexpr const char *SystemCacheDir = "/var/cache/pacman/pkg";
+
+std::string prefetchCacheDir() {
+  std::string Dir = cacheDir() + "/pkg";
+  std::error_code Ec;
+  fs::create_directories(Dir, Ec);
+  return Dir;
+}
+
+bool startPrefetch(PtyProcess &Proc) {
+  std::vector<PackageUpdate> Pending = parseUpdateList(readFile(repoUpdatesPath()));
+  if (Pending.empty()) {
+    return false;
+  }
+  const Config &Cfg = getConfig();
+
+  // Bandwidth limits go through a private pacman.conf that downloads with curl
+  PacmanConfOverrides Overrides;
+  if (!Cfg.PrefetchRate.empty()) {
+    Overrides.XferCommand = std::format("/usr/bin/curl -L -C - -f -s --limit-rate {} -o %o %u", Cfg.PrefetchRate);
+  }
+  if (Cfg.MirrorProbe) {
+    Overrides.Server = bestMirror();
+  }
+  std::string PacmanConf = writePacmanConf(cacheDir() + "/prefetch.conf", Overrides);
+
+  // The check DB is refreshed by each check, so this never touches the system DB
+  std::string Cmd = expandPlaceholders(Cfg.PrefetchCommand, {{"dbpath", shellQuote(checkDbPath())},
+                                                             {"cachedir", shellQuote(prefetchCacheDir())},
+                                                             {"config", shellQuote(PacmanConf)}});
+  for (const PackageUpdate &Update : Pending) {
+    Cmd += " " + shellQuote(Update.Name);
+  }
+  return spawnPty(Cmd, Proc);
+}
+
+// Package files pacman may have stored an update as; architecture independent packages are "any"
+static constexpr std::array<const char *, 2> PackageExtensions = {".pkg.tar.zst", ".pkg.tar.xz"};
+
+// Size of the first cache file holding Update, looked up by name instead of listing the caches
+static bool isCached(const PackageUpdate &Update, const std::array<std::string, 2> &Dirs, std::uintmax_t &Bytes) {
+  for (const std::string &Dir : Dirs) {
+    for (const std::string &Arch : {pacmanArchitecture(), std::string("any")}) {
+      for (const char *Extension : PackageExtensions) {
+        std::error_code Ec;
+        std::uintmax_t Size = fs::file_size(std::format("{}/{}-{}-{}{}", Dir, Update.Name, Update.NewVersion, Arch, Extension), Ec);
+        if (Ec) continue;
+        Bytes += Size;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+CacheSummary summarizeCache() {
+  CacheSummary Summary;
+  std::vector<PackageUpdate> Pending = parseUpdateList(readFile(repoUpdatesPath()));
+  Summary.Total = static_cast<int>(Pending.size());
+  std::array<std::string, 2> Dirs = {SystemCacheDir, prefetchCacheDir()};
+  for (const PackageUpdate &Update : Pending) {
+    if (isCached(Update, Dirs, Summary.CachedBytes)) Summary.Cached++;
+  }
+  return Summary;
+}
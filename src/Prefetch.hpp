@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Pty.hpp"
+#include <cstdint>
+#include <string>
+
+// How much of the pending repo update is already in a package cache
+struct CacheSummary {
+  int Cached = 0;
+  int Total = 0;
+  std::uintmax_t CachedBytes = 0;
+};
+
+std::string prefetchCacheDir();
+
+bool startPrefetch(PtyProcess &Proc);
+CacheSummary summarizeCache();
@@ -0,0 +1,147 @@
+#include "Pty.hpp"
+#include "Terminal.hpp"
+#include <array>
+#include <cerrno>
+#include <fcntl.h>
+#include <pty.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// A call drains the pty until it is empty; only a child that writes as fast as it is read hits this bound.
+// It is time rather than bytes, so throughput doesn't depend on how often the UI gets to read.
+static constexpr std::chrono::milliseconds MaxReadTime{20};
+
+// Time a stopped process tree gets to exit on SIGINT before it is killed
+static constexpr std::chrono::seconds StopGracePeriod{3};
+
+// Children closed before they exited, until they are reaped
+static std::vector<PtyProcess> g_Unreaped;
+
+static int decodeStatus(int Status) {
+  if (WIFEXITED(Status)) return WEXITSTATUS(Status);
+  if (WIFSIGNALED(Status)) return 128 + WTERMSIG(Status);
+  return Status;
+}
+
+bool spawnPty(const std::string &Cmd, PtyProcess &Proc, const EnvList &Env, const ResourcePolicy *Policy) {
+  std::string Command = Policy ? governedCommand(Cmd, *Policy) : Cmd;
+
+  struct winsize Size = {};
+  Size.ws_col = PtyColumns;
+  Size.ws_row = PtyRows;
+
+  int Master = -1;
+  pid_t Pid = forkpty(&Master, nullptr, nullptr, &Size);
+  if (Pid < 0) {
+    return false;
+  }
+  if (Pid == 0) {
+    // Child: the pty slave is already our stdin/stdout/stderr
+    setenv("TERM", "dumb", 1);
+    for (const auto &[Name, Value] : Env) {
+      setenv(Name.c_str(), Value.c_str(), 1);
+    }
+    if (Policy) {
+      applyPriorities(*Policy);
+    }
+    execl("/bin/sh", "sh", "-c", Command.c_str(), static_cast<char *>(nullptr));
+    _exit(127);
+  }
+
+  fcntl(Master, F_SETFL, fcntl(Master, F_GETFL) | O_NONBLOCK);
+  Proc.Pid = Pid;
+  Proc.MasterFD = Master;
+  Proc.ExitStatus = -1;
+  Proc.Stopping = false;
+  return true;
+}
+
+PtyStatus readPty(PtyProcess &Proc, std::string &Out) {
+  // Escalate if a stopped tree ignored SIGINT
+  if (Proc.Stopping && Proc.ExitStatus < 0 && std::chrono::steady_clock::now() - Proc.StopTime > StopGracePeriod) {
+    kill(-Proc.Pid, SIGKILL);
+    Proc.Stopping = false;
+  }
+
+  std::array<char, 64 * 1024> Buffer;
+  size_t Total = 0;
+  auto Deadline = std::chrono::steady_clock::now() + MaxReadTime;
+  while (true) {
+    ssize_t BytesRead = read(Proc.MasterFD, Buffer.data(), Buffer.size());
+    if (BytesRead > 0) {
+      Out.append(Buffer.data(), BytesRead);
+      Total += BytesRead;
+      if (std::chrono::steady_clock::now() > Deadline) break;
+      continue;
+    }
+    // Linux reports EIO on the master once every slave fd has been closed
+    if (BytesRead == 0 || errno == EIO) {
+      // The child is only reported once reaped, so closePty() never has to wait for it
+      if (Proc.ExitStatus < 0) {
+        int Status = 0;
+        if (waitpid(Proc.Pid, &Status, WNOHANG) == 0) return PtyStatus::Running;
+        Proc.ExitStatus = decodeStatus(Status);
+      }
+      return PtyStatus::Exited;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      return PtyStatus::Error;
+    }
+    break;
+  }
+
+  // A grandchild may keep the slave open after the command itself is done
+  if (Proc.ExitStatus < 0 && Total == 0) {
+    int Status = 0;
+    if (waitpid(Proc.Pid, &Status, WNOHANG) == Proc.Pid) {
+      Proc.ExitStatus = decodeStatus(Status);
+      return PtyStatus::Exited;
+    }
+  }
+  return PtyStatus::Running;
+}
+
+void stopPty(PtyProcess &Proc) {
+  // forkpty() made the child a session leader, so this reaches everything it started. SIGINT rather
+  // than SIGTERM: pacman handles it and only stops where its database stays consistent.
+  if (Proc.Pid > 0 && Proc.ExitStatus < 0 && !Proc.Stopping) {
+    kill(-Proc.Pid, SIGINT);
+    Proc.Stopping = true;
+    Proc.StopTime = std::chrono::steady_clock::now();
+  }
+}
+
+void holdPty(PtyProcess &Proc) { Proc.Stopping = false; }
+
+int closePty(PtyProcess &Proc) {
+  if (Proc.MasterFD >= 0) {
+    close(Proc.MasterFD);
+  }
+  if (Proc.Pid > 0 && Proc.ExitStatus < 0) {
+    // Closed before it exited, e.g. after a read error: reapPtys() waits for it, escalating a stop as readPty() would
+    int Status = 0;
+    if (waitpid(Proc.Pid, &Status, WNOHANG) == Proc.Pid) {
+      Proc.ExitStatus = decodeStatus(Status);
+    } else {
+      g_Unreaped.push_back(Proc);
+    }
+  }
+  int ExitStatus = Proc.ExitStatus;
+  Proc = PtyProcess{};
+  return ExitStatus;
+}
+
+void reapPtys() {
+  auto Now = std::chrono::steady_clock::now();
+  std::erase_if(g_Unreaped, [Now](PtyProcess &Proc) {
+    if (Proc.Stopping && Now - Proc.StopTime > StopGracePeriod) {
+      kill(-Proc.Pid, SIGKILL);
+      Proc.Stopping = false;
+    }
+    return waitpid(Proc.Pid, nullptr, WNOHANG) != 0;
+  });
+}
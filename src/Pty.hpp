@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Resources.hpp"
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+
+struct PtyProcess {
+  pid_t Pid = -1;
+  int MasterFD = -1;
+  int ExitStatus = -1; // Set once the child has been reaped
+  bool Stopping = false; // SIGINT sent, SIGKILL follows if it doesn't exit (unless held)
+  std::chrono::steady_clock::time_point StopTime;
+
+  bool active() const { return Pid > 0; }
+};
+
+enum class PtyStatus { Running, Exited, Error };
+
+// Extra environment variables are only set in the child
+using EnvList = std::vector<std::pair<std::string, std::string>>;
+
+// With a policy, the command runs with lowered priorities and inside a cgroup scope if limits are set
+bool spawnPty(const std::string &Cmd, PtyProcess &Proc, const EnvList &Env = {}, const ResourcePolicy *Policy = nullptr);
+// Appends everything the child has written so far, or what arrived within a few milliseconds if it keeps writing
+PtyStatus readPty(PtyProcess &Proc, std::string &Out);
+// Interrupts the whole process tree like Ctrl-C would, escalating to SIGKILL after a grace period
+void stopPty(PtyProcess &Proc);
+// Drops a pending escalation; the interrupted tree is left to finish on its own
+void holdPty(PtyProcess &Proc);
+// Never waits: a child that hasn't exited yet is reaped by reapPtys() later, and -1 is returned
+int closePty(PtyProcess &Proc);
+// Reaps children closePty() left behind; called from the main loop
+void reapPtys();
@@ -0,0 +1,75 @@
+#include "Render.hpp"
+#include "Config.hpp"
+#include "GLFW/glfw3.h"
+#include "imgui.h"
+#include <bit>
+#include <cstring>
+#include <string_view>
+
+// Eight bytes per step; the rotation spreads high bits back down so they are not lost
+static void mix(std::uint64_t &Hash, const void *Data, std::size_t Size) {
+  const unsigned char *Bytes = static_cast<const unsigned char *>(Data);
+  std::size_t I = 0;
+  for (; I + 8 <= Size; I += 8) {
+    std::uint64_t Word;
+    std::memcpy(&Word, Bytes + I, 8);
+    Hash = std::rotl((Hash ^ Word) * 0x9E3779B97F4A7C15ULL, 31);
+  }
+  for (; I < Size; ++I) {
+    Hash = std::rotl((Hash ^ Bytes[I]) * 0x9E3779B97F4A7C15ULL, 31);
+  }
+}
+
+template <typename T> static void mix(std::uint64_t &Hash, const T &Value) { mix(Hash, &Value, sizeof(Value)); }
+
+std::uint64_t hashDrawData(const ImDrawData *DrawData) {
+  std::uint64_t Hash = 0xCBF29CE484222325ULL;
+  mix(Hash, DrawData->DisplayPos);
+  mix(Hash, DrawData->DisplaySize);
+  mix(Hash, DrawData->FramebufferScale);
+  for (const ImDrawList *List : DrawData->CmdLists) {
+    mix(Hash, List->VtxBuffer.Data, List->VtxBuffer.size_in_bytes());
+    mix(Hash, List->IdxBuffer.Data, List->IdxBuffer.size_in_bytes());
+    for (const ImDrawCmd &Cmd : List->CmdBuffer) {
+      mix(Hash, Cmd.ClipRect);
+      mix(Hash, Cmd.TexRef);
+      mix(Hash, Cmd.VtxOffset);
+      mix(Hash, Cmd.IdxOffset);
+      mix(Hash, Cmd.ElemCount);
+      mix(Hash, Cmd.UserCallback);
+    }
+  }
+  return Hash;
+}
+
+bool FrameSkipper::needsPresent(const ImDrawData *DrawData) {
+  // Font atlas uploads happen inside the backend's render call, so such frames always go through
+  bool TexturesPending = false;
+  if (DrawData->Textures) {
+    for (const ImTextureData *Texture : *DrawData->Textures) {
+      TexturesPending |= Texture->Status != ImTextureStatus_OK && Texture->Status != ImTextureStatus_Destroyed;
+    }
+  }
+  std::uint64_t Hash = hashDrawData(DrawData);
+  if (Valid && Hash == LastHash && !TexturesPending) return false;
+  LastHash = Hash;
+  Valid = true;
+  return true;
+}
+
+bool softwareRenderer() {
+  const char *Renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+  if (!Renderer) return false;
+  std::string_view Name = Renderer;
+  for (std::string_view Software : {"llvmpipe", "softpipe", "SwiftShader", "Software Rasterizer"}) {
+    if (Name.find(Software) != std::string_view::npos) return true;
+  }
+  return false;
+}
+
+bool lowOverheadRendering() {
+  const std::string &Mode = getConfig().RenderMode;
+  if (Mode == "low") return true;
+  if (Mode == "full") return false;
+  return softwareRenderer();
+}
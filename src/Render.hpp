@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+struct ImDrawData;
+
+// Remembers what the last presented frame looked like, so an identical frame is neither
+// uploaded nor drawn nor swapped. On a software rasterizer that is most of a frame's cost.
+class FrameSkipper {
+public:
+  // False if DrawData would draw exactly what is already on screen
+  bool needsPresent(const ImDrawData *DrawData);
+  // The window's contents were lost (exposed, shown again), so the next frame must be drawn
+  void invalidate() { Valid = false; }
+
+private:
+  std::uint64_t LastHash = 0;
+  bool Valid = false;
+};
+
+std::uint64_t hashDrawData(const ImDrawData *DrawData);
+// Whether the current GL context rasterizes on the CPU (llvmpipe, softpipe, SwiftShader)
+bool softwareRenderer();
+// render_mode "low" or "full"; "auto" takes the low-overhead path on software renderers only
+bool lowOverheadRendering();
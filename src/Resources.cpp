@@ -0,0 +1,31 @@
+#include "Resources.hpp"
+#include "Utils.hpp"
+#include <format>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// From linux/ioprio.h, which isn't wrapped by glibc
+static constexpr int IoprioWhoProcess = 1;
+static constexpr int IoprioClassShift = 13;
+
+std::string governedCommand(const std::string &Cmd, const ResourcePolicy &Policy) {
+  if (Policy.CpuQuota.empty() && Policy.MemoryMax.empty()) {
+    return Cmd;
+  }
+  // sudo'd children stay in the scope too, since cgroup membership is inherited
+  std::string Properties;
+  if (!Policy.CpuQuota.empty()) Properties += std::format(" -p CPUQuota={}", shellQuote(Policy.CpuQuota));
+  if (!Policy.MemoryMax.empty()) Properties += std::format(" -p MemoryMax={}", shellQuote(Policy.MemoryMax));
+  return std::format("systemd-run --user --scope --quiet --collect{} -- /bin/sh -c {}", Properties, shellQuote(Cmd));
+}
+
+void applyPriorities(const ResourcePolicy &Policy) {
+  if (Policy.Nice != 0) {
+    setpriority(PRIO_PROCESS, 0, Policy.Nice);
+  }
+  if (Policy.IoClass > 0) {
+    int Level = Policy.IoClass == 3 ? 0 : Policy.IoLevel;
+    syscall(SYS_ioprio_set, IoprioWhoProcess, 0, (Policy.IoClass << IoprioClassShift) | Level);
+  }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+// Priorities and limits for the update process tree; the defaults change nothing
+struct ResourcePolicy {
+  int Nice = 0;             // setpriority() value, 0 keeps the default
+  int IoClass = 0;          // 0 none, 1 realtime, 2 best-effort, 3 idle
+  int IoLevel = 7;          // 0 (highest) - 7 (lowest), for realtime and best-effort
+  std::string CpuQuota;     // systemd CPUQuota=, e.g. "200%"; empty means no limit
+  std::string MemoryMax;    // systemd MemoryMax=, e.g. "4G"; empty means no limit
+};
+
+// Wraps Cmd in a transient systemd scope when cgroup limits are configured
+std::string governedCommand(const std::string &Cmd, const ResourcePolicy &Policy);
+// Lowers CPU and I/O priority of the calling process, inherited by everything it starts
+void applyPriorities(const ResourcePolicy &Policy);
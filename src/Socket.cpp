@@ -0,0 +1,165 @@
+#include "Socket.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+bool isUnixAddress(const std::string &Address) {
+  return Address.starts_with("unix:") || Address.starts_with('/') || Address.starts_with('@');
+}
+
+// Fills a sockaddr_un, returning the length to pass to bind()/connect() or 0 if the path is too long
+static socklen_t unixAddress(const std::string &Address, sockaddr_un &Addr) {
+  std::string Path = Address.starts_with("unix:") ? Address.substr(5) : Address;
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  if (Path.size() >= sizeof(Addr.sun_path)) return 0;
+  memcpy(Addr.sun_path, Path.data(), Path.size());
+  // Abstract sockets start with a NUL byte and are not NUL terminated
+  if (Path.starts_with('@')) {
+    Addr.sun_path[0] = '\0';
+    return offsetof(sockaddr_un, sun_path) + Path.size();
+  }
+  return sizeof(Addr);
+}
+
+static addrinfo *resolve(const std::string &Address, int Flags) {
+  std::size_t Colon = Address.rfind(':');
+  if (Colon == std::string::npos) return nullptr;
+  // Without a host, both ends agree on IPv4 loopback
+  std::string Host = Colon == 0 ? "127.0.0.1" : Address.substr(0, Colon);
+  std::string Port = Address.substr(Colon + 1);
+  addrinfo Hints = {};
+  Hints.ai_family = AF_UNSPEC;
+  Hints.ai_socktype = SOCK_STREAM;
+  Hints.ai_flags = Flags;
+  addrinfo *Result = nullptr;
+  if (getaddrinfo(Host.c_str(), Port.c_str(), &Hints, &Result) != 0) return nullptr;
+  return Result;
+}
+
+// INADDR_ANY or in6addr_any: every interface of the host
+static bool isWildcard(const sockaddr *Addr) {
+  if (Addr->sa_family == AF_INET) return reinterpret_cast<const sockaddr_in *>(Addr)->sin_addr.s_addr == htonl(INADDR_ANY);
+  if (Addr->sa_family == AF_INET6) return IN6_IS_ADDR_UNSPECIFIED(&reinterpret_cast<const sockaddr_in6 *>(Addr)->sin6_addr);
+  return false;
+}
+
+bool isWildcardAddress(const std::string &Address) {
+  if (isUnixAddress(Address)) return false;
+  addrinfo *Info = resolve(Address, 0);
+  if (!Info) return false;
+  bool Wildcard = isWildcard(Info->ai_addr);
+  freeaddrinfo(Info);
+  return Wildcard;
+}
+
+int listenSocket(const std::string &Address) {
+  int Fd = -1;
+  if (isUnixAddress(Address)) {
+    sockaddr_un Addr;
+    socklen_t Len = unixAddress(Address, Addr);
+    if (Len == 0) return -1;
+    Fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    // Stale socket file from a previous run; anything else at that path is left for bind() to refuse
+    struct stat Info;
+    if (Addr.sun_path[0] != '\0' && lstat(Addr.sun_path, &Info) == 0 && S_ISSOCK(Info.st_mode)) unlink(Addr.sun_path);
+    if (Fd < 0 || bind(Fd, reinterpret_cast<sockaddr *>(&Addr), Len) < 0) {
+      if (Fd >= 0) close(Fd);
+      return -1;
+    }
+  } else {
+    // No AI_PASSIVE: every interface has to be asked for explicitly
+    addrinfo *Info = resolve(Address, 0);
+    if (!Info) return -1;
+    Fd = socket(Info->ai_family, Info->ai_socktype | SOCK_CLOEXEC, Info->ai_protocol);
+    int One = 1;
+    if (Fd >= 0) setsockopt(Fd, SOL_SOCKET, SO_REUSEADDR, &One, sizeof(One));
+    if (Fd < 0 || bind(Fd, Info->ai_addr, Info->ai_addrlen) < 0) {
+      if (Fd >= 0) close(Fd);
+      freeaddrinfo(Info);
+      return -1;
+    }
+    freeaddrinfo(Info);
+  }
+  if (listen(Fd, 64) < 0) {
+    close(Fd);
+    return -1;
+  }
+  return Fd;
+}
+
+static int connectTo(const addrinfo *Info) {
+  int Fd = socket(Info->ai_family, Info->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, Info->ai_protocol);
+  if (Fd < 0) return -1;
+  if (connect(Fd, Info->ai_addr, Info->ai_addrlen) < 0 && errno != EINPROGRESS && errno != EAGAIN) {
+    close(Fd);
+    return -1;
+  }
+  return Fd;
+}
+
+int connectSocket(const std::string &Address) {
+  if (!isUnixAddress(Address)) {
+    addrinfo *Info = resolve(Address, AI_NUMERICHOST);
+    if (!Info) return -1;
+    int Fd = connectTo(Info);
+    freeaddrinfo(Info);
+    return Fd;
+  }
+  sockaddr_un Addr;
+  socklen_t Len = unixAddress(Address, Addr);
+  if (Len == 0) return -1;
+  int Fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (Fd < 0) return -1;
+  if (connect(Fd, reinterpret_cast<sockaddr *>(&Addr), Len) < 0 && errno != EINPROGRESS && errno != EAGAIN) {
+    close(Fd);
+    return -1;
+  }
+  return Fd;
+}
+
+int socketError(int Fd) {
+  int Error = 0;
+  socklen_t Len = sizeof(Error);
+  if (getsockopt(Fd, SOL_SOCKET, SO_ERROR, &Error, &Len) < 0) return errno;
+  return Error;
+}
+
+AddressLookup::AddressLookup(const std::string &Address) {
+  std::size_t Colon = Address.rfind(':');
+  if (Colon == std::string::npos) {
+    StartError = EAI_NONAME;
+    return;
+  }
+  Host = Colon == 0 ? "127.0.0.1" : Address.substr(0, Colon);
+  Port = Address.substr(Colon + 1);
+  Hints.ai_family = AF_UNSPEC;
+  Hints.ai_socktype = SOCK_STREAM;
+  Request.ar_name = Host.c_str();
+  Request.ar_service = Port.c_str();
+  Request.ar_request = &Hints;
+  gaicb *List[] = {&Request};
+  StartError = getaddrinfo_a(GAI_NOWAIT, List, 1, nullptr);
+}
+
+AddressLookup::~AddressLookup() {
+  if (!cancel()) {
+    // Still being written to by glibc's resolver thread
+    const gaicb *List[] = {&Request};
+    while (gai_error(&Request) == EAI_INPROGRESS) gai_suspend(List, 1, nullptr);
+  }
+  if (Request.ar_result) freeaddrinfo(Request.ar_result);
+}
+
+int AddressLookup::error() { return StartError != 0 ? StartError : gai_error(&Request); }
+
+int AddressLookup::connect() const { return Request.ar_result ? connectTo(Request.ar_result) : -1; }
+
+bool AddressLookup::cancel() { return StartError != 0 || gai_cancel(&Request) != EAI_NOTCANCELED; }
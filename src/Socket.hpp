@@ -0,0 +1,40 @@
+#pragma once
+
+#include <netdb.h>
+#include <string>
+
+// Addresses are "unix:/path", "/path", "@name" (abstract UNIX socket) or "host:port" (TCP)
+bool isUnixAddress(const std::string &Address);
+// A UNIX path is only replaced if what is there is a socket. A TCP address without a host (":port") is 127.0.0.1.
+int listenSocket(const std::string &Address);
+// TCP address that listens on every interface, like "0.0.0.0:7777" or ":::7777"
+bool isWildcardAddress(const std::string &Address);
+// Starts a non-blocking connect; the fd becomes writable once it has completed. TCP hosts must be
+// literal addresses here so nothing blocks on DNS; names go through an AddressLookup first.
+int connectSocket(const std::string &Address);
+// Result of a non-blocking connect, 0 on success or an errno value
+int socketError(int Fd);
+
+// Resolves the host of a "host:port" address in the background (getaddrinfo_a), so a single
+// thread can look up many hosts at once
+class AddressLookup {
+public:
+  explicit AddressLookup(const std::string &Address);
+  ~AddressLookup();
+  AddressLookup(const AddressLookup &) = delete;
+  AddressLookup &operator=(const AddressLookup &) = delete;
+
+  // EAI_INPROGRESS while running, then 0 or the EAI_* error
+  int error();
+  // Starts a non-blocking connect to the first address found, like connectSocket()
+  int connect() const;
+  // Abandons a running lookup; false if glibc is still writing to it, so it must outlive that
+  bool cancel();
+
+private:
+  std::string Host;
+  std::string Port;
+  addrinfo Hints = {};
+  gaicb Request = {};
+  int StartError = 0;
+};
@@ -0,0 +1,144 @@
+#include "SyncDb.hpp"
+#include "Config.hpp"
+#include "Mirrors.hpp"
+#include "PacmanConf.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+static constexpr const char *SystemLocalDb = "/var/lib/pacman/local";
+// Servers tried per repo before giving up; when the network is down, each one costs a timeout
+static constexpr std::size_t MaxServerAttempts = 3;
+
+std::string checkDbPath() { return cacheDir() + "/db"; }
+
+static std::vector<std::string> outputLines(const std::string &Output) {
+  std::vector<std::string> Lines;
+  std::istringstream Stream(Output);
+  std::string Line;
+  while (std::getline(Stream, Line)) {
+    if (!Line.empty()) Lines.push_back(Line);
+  }
+  return Lines;
+}
+
+std::vector<std::string> syncRepos() {
+  const Config &Cfg = getConfig();
+  if (!Cfg.CheckRepos.empty()) return Cfg.CheckRepos;
+  return outputLines(executeCommand("pacman-conf --repo-list"));
+}
+
+// Base URLs of a repo's DB, in the order they are tried. The configured check mirror or the fastest
+// probed one only goes in front of the mirrorlist; repos with their own servers keep pacman's order.
+static std::vector<std::string> repoServers(const std::string &Repo, const std::vector<std::string> &MirrorListRepos) {
+  const Config &Cfg = getConfig();
+  std::vector<std::string> Servers;
+  std::string Mirror = Cfg.CheckMirror;
+  if (Mirror.empty() && Cfg.MirrorProbe) Mirror = bestMirror();
+  if (!Mirror.empty() && std::ranges::find(MirrorListRepos, Repo) != MirrorListRepos.end()) {
+    Servers.push_back(expandServer(Mirror, Repo));
+  }
+  for (std::string &Server : outputLines(executeCommand(std::format("pacman-conf --repo={} Server", shellQuote(Repo)).c_str()))) {
+    if (std::ranges::find(Servers, Server) == Servers.end()) Servers.push_back(std::move(Server));
+  }
+  // Not in pacman.conf at all, like a check_repos entry served by a local test mirror
+  if (Servers.empty() && !Cfg.CheckMirror.empty()) Servers.push_back(expandServer(Cfg.CheckMirror, Repo));
+  return Servers;
+}
+
+// Starts the conditional download of a repo's DB from one server
+static std::string downloadCommand(const fs::path &Sync, const std::string &Repo, const std::string &Server) {
+  const Config &Cfg = getConfig();
+  std::error_code Ec;
+  fs::path File = Sync / (Repo + ".db");
+  // Downloads go to .part files, so a failed transfer never replaces a good DB.
+  // -R keeps the server's modification time, which -z then sends back as If-Modified-Since.
+  std::string Cmd = std::format("curl -fsSL -R --connect-timeout 10 --max-time {} -w '%{{http_code}}' -o {} --etag-save {}",
+                                Cfg.CheckTimeout, shellQuote(File.string() + ".part"), shellQuote(File.string() + ".etag.part"));
+  if (fs::exists(File, Ec)) {
+    Cmd += " -z " + shellQuote(File.string());
+    // Without a saved ETag curl would skip the request's conditions altogether
+    if (fs::exists(File.string() + ".etag", Ec)) Cmd += " --etag-compare " + shellQuote(File.string() + ".etag");
+  }
+  Cmd += " " + shellQuote(std::format("{}/{}.db", Server, Repo));
+  return Cmd;
+}
+
+bool refreshSyncDb(bool Debug) {
+  fs::path Db = checkDbPath();
+  fs::path Sync = Db / "sync";
+  std::error_code Ec;
+  fs::create_directories(Sync, Ec);
+
+  // pacman looks for the installed packages next to the sync DBs; they are only ever read through this link
+  fs::path Local = Db / "local";
+  if (!fs::is_symlink(Local, Ec)) {
+    fs::remove_all(Local, Ec);
+    fs::create_directory_symlink(SystemLocalDb, Local, Ec);
+  }
+
+  std::vector<std::string> Repos = syncRepos();
+  std::vector<std::string> MirrorListRepos = mirrorListRepos();
+  std::vector<std::vector<std::string>> Servers;
+  for (const std::string &Repo : Repos) Servers.push_back(repoServers(Repo, MirrorListRepos));
+
+  // Every repo starts with its first server; the ones that failed move on to their next one together
+  std::vector<bool> Done(Repos.size(), false);
+  for (std::size_t Attempt = 0; Attempt < MaxServerAttempts; ++Attempt) {
+    std::vector<std::size_t> Pending;
+    std::vector<std::string> Cmds;
+    for (std::size_t I = 0; I < Repos.size(); ++I) {
+      if (Done[I] || Attempt >= Servers[I].size()) continue;
+      Pending.push_back(I);
+      Cmds.push_back(downloadCommand(Sync, Repos[I], Servers[I][Attempt]));
+    }
+    if (Cmds.empty()) break;
+
+    std::vector<std::string> Results = executeCommands(Cmds, Cmds.size(), Debug);
+    for (std::size_t J = 0; J < Pending.size(); ++J) {
+      std::size_t I = Pending[J];
+      std::string File = (Sync / (Repos[I] + ".db")).string();
+      std::string_view Status = Results[J];
+      if (Status.ends_with('\n')) Status.remove_suffix(1);
+      if (Status == "200") {
+        fs::rename(File + ".part", File, Ec);
+        // file_size() returns -1 on error, which must not count as a saved ETag
+        std::uintmax_t EtagSize = fs::file_size(File + ".etag.part", Ec);
+        if (!Ec && EtagSize > 0) {
+          fs::rename(File + ".etag.part", File + ".etag", Ec);
+        } else {
+          fs::remove(File + ".etag", Ec);
+        }
+        Done[I] = true;
+      } else if (Status == "304") {
+        Done[I] = true;
+      } else if (Debug) {
+        std::cerr << std::format("Refreshing the {} DB from {} failed (HTTP status {})\n", Repos[I], Servers[I][Attempt],
+                                 Status.empty() ? "none" : Status);
+      }
+      fs::remove(File + ".part", Ec);
+      fs::remove(File + ".etag.part", Ec);
+    }
+  }
+
+  bool Ok = true;
+  for (std::size_t I = 0; I < Repos.size(); ++I) {
+    if (Done[I]) continue;
+    if (Debug) std::cerr << std::format("No server had the {} DB\n", Repos[I]);
+    Ok = false;
+  }
+  return Ok;
+}
+
+std::optional<std::string> checkRepoUpdates(bool Debug) {
+  // A missing or outdated DB would quietly hide updates, so that is an error rather than an empty list
+  if (!refreshSyncDb(Debug)) return std::nullopt;
+  // A query needs no lock and writes nothing, so the system DB stays untouched
+  return executeCommand(std::format("pacman -Qu --dbpath {}", shellQuote(checkDbPath())).c_str(), Debug);
+}
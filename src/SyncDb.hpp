@@ -0,0 +1,16 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// imupdate's own sync DBs (~/.cache/imupdate/db), kept between checks and refreshed with
+// conditional requests. The system DB is never written: "local" is a link to the installed-package DB.
+std::string checkDbPath();
+std::vector<std::string> syncRepos();
+// Downloads the DBs of all repos at once, transferring only those that changed. A repo whose server
+// fails is tried again from its next one; false if some repo could not be refreshed from any.
+bool refreshSyncDb(bool Debug = false);
+// Pending repo updates as "name old -> new" lines, like checkupdates prints them; nothing if the
+// DBs could not be refreshed
+std::optional<std::string> checkRepoUpdates(bool Debug = false);
@@ -0,0 +1,168 @@
+#include "Terminal.hpp"
+#include <algorithm>
+#include <charconv>
+
+void TerminalBuffer::clear() {
+  Text.clear();
+  Lines.assign(1, 0);
+  Top = 0;
+  Row = 0;
+  Cursor = 0;
+  State = EscapeState::None;
+  Params.clear();
+  ++Generation;
+}
+
+void TerminalBuffer::feed(std::string_view Chunk) {
+  for (char C : Chunk) {
+    // Escape sequences may be split across reads, so the parser state is kept between calls
+    switch (State) {
+    case EscapeState::Escape:
+      if (C == '[') {
+        State = EscapeState::Csi;
+        Params.clear();
+      } else if (C == ']') {
+        State = EscapeState::Osc;
+      } else if (C == '(' || C == ')') {
+        State = EscapeState::Charset;
+      } else {
+        State = EscapeState::None;
+      }
+      continue;
+    case EscapeState::Csi:
+      if (C >= 0x40 && C <= 0x7E) {
+        runCsi(C);
+        State = EscapeState::None;
+      } else {
+        Params += C;
+      }
+      continue;
+    case EscapeState::Osc:
+      // Window titles etc. end with BEL or ESC '\'
+      if (C == '\a') {
+        State = EscapeState::None;
+      } else if (C == '\x1B') {
+        State = EscapeState::Escape;
+      }
+      continue;
+    case EscapeState::Charset:
+      State = EscapeState::None;
+      continue;
+    case EscapeState::None:
+      break;
+    }
+
+    switch (C) {
+    case '\x1B':
+      State = EscapeState::Escape;
+      break;
+    case '\r':
+      Cursor = 0;
+      break;
+    case '\n':
+      newline();
+      break;
+    case '\b':
+      if (Cursor > 0) Cursor--;
+      break;
+    case '\t':
+      do {
+        put(' ');
+      } while (Cursor % 8 != 0);
+      break;
+    default:
+      // Drop the remaining control characters (BEL, NUL, ...)
+      if (static_cast<unsigned char>(C) >= 0x20 && C != 0x7F) {
+        put(C);
+      }
+      break;
+    }
+  }
+}
+
+std::string_view TerminalBuffer::line(std::size_t Index) const {
+  std::size_t End = Index + 1 < Lines.size() ? Lines[Index + 1] - 1 : Text.size();
+  return std::string_view(Text).substr(Lines[Index], End - Lines[Index]);
+}
+
+std::size_t TerminalBuffer::lineEnd() const {
+  // Lines above the last one end at their '\n'
+  return Row + 1 < Lines.size() ? Lines[Row + 1] - 1 : Text.size();
+}
+
+void TerminalBuffer::resizeLine(std::size_t Size) {
+  std::size_t End = lineEnd();
+  std::size_t NewEnd = Lines[Row] + Size;
+  if (NewEnd > End) {
+    Text.insert(End, NewEnd - End, ' ');
+  } else {
+    Text.erase(NewEnd, End - NewEnd);
+  }
+  // Only the lines below the cursor move, and there are at most PtyRows of them
+  for (std::size_t I = Row + 1; I < Lines.size(); ++I) Lines[I] = Lines[I] - End + NewEnd;
+}
+
+void TerminalBuffer::put(char C) {
+  // The cursor may have been moved past the end of the line
+  if (Lines[Row] + Cursor >= lineEnd()) resizeLine(Cursor + 1);
+  Text[Lines[Row] + Cursor] = C;
+  Cursor++;
+}
+
+void TerminalBuffer::newline() {
+  // A newline keeps whatever is left on the line after the cursor, like a real terminal
+  Cursor = 0;
+  if (Row + 1 < Lines.size()) {
+    ++Row; // Back down into a line that was already written
+    return;
+  }
+  Text.push_back('\n');
+  Lines.push_back(Text.size());
+  ++Row;
+  // Lines scrolled off the screen can't be reached anymore
+  if (Lines.size() - Top > PtyRows) ++Top;
+}
+
+void TerminalBuffer::runCsi(char Final) {
+  int N = 0;
+  std::from_chars(Params.data(), Params.data() + Params.size(), N);
+  // Moves default to 1 and can't go past the screen, so a huge count can't blow up a line
+  std::size_t Count = N > 0 ? std::min<std::size_t>(N, PtyColumns) : 1;
+  std::size_t Start = Lines[Row];
+  std::size_t LineEnd = lineEnd();
+
+  switch (Final) {
+  case 'K': // Erase in line
+    if (N == 0) {
+      if (Start + Cursor < LineEnd) resizeLine(Cursor);
+    } else if (N == 1) {
+      std::fill(Text.begin() + Start, Text.begin() + std::min(LineEnd, Start + Cursor + 1), ' ');
+    } else {
+      resizeLine(0);
+    }
+    break;
+  case 'G': // Cursor horizontal absolute (1-based)
+    Cursor = Count - 1;
+    break;
+  case 'C': // Cursor forward, stopping at the last column
+    Cursor = std::min<std::size_t>(Cursor + Count, PtyColumns - 1);
+    break;
+  case 'D': // Cursor back
+    Cursor -= std::min(Cursor, Count);
+    break;
+  case 'A': // Cursor up
+  case 'F': // Cursor to the start of a previous line
+    if (Row > Top) ++Rewinds;
+    Row -= std::min(Row - Top, Count);
+    if (Final == 'F') Cursor = 0;
+    break;
+  case 'B': // Cursor down, only into lines that exist
+  case 'E': // Cursor to the start of a next line
+    Row = std::min(Row + Count, Lines.size() - 1);
+    if (Final == 'E') Cursor = 0;
+    break;
+  default:
+    // Colors, cursor visibility and absolute positioning are ignored
+    break;
+  }
+}
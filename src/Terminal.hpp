@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Terminal size reported to children run in a pty, roughly what fits in the output region
+inline constexpr unsigned short PtyColumns = 100;
+inline constexpr unsigned short PtyRows = 40;
+
+// Small terminal line model for output read from a pseudo-terminal.
+// '\r' moves back to the start of the current line, so progress bars
+// overwrite themselves instead of being appended over and over. The cursor
+// can also move up into the last PtyRows lines, like pacman's parallel
+// download bars do.
+class TerminalBuffer {
+public:
+  void feed(std::string_view Chunk);
+  void clear();
+
+  const std::string &text() const { return Text; }
+  bool empty() const { return Text.empty(); }
+  // Lines are separated by '\n'; the last one may still be empty
+  std::size_t lineCount() const { return Lines.size(); }
+  std::string_view line(std::size_t Index) const;
+  // Finished lines end before this offset; it only moves back when the cursor moves up
+  std::size_t committedSize() const { return Lines[Row]; }
+  // Text before this offset can never change again: the cursor can't reach it anymore
+  std::size_t screenStart() const { return Lines[Top]; }
+  // Counts cursor moves back up into finished lines, which may then be rewritten
+  std::size_t rewinds() const { return Rewinds; }
+  // Changes on every clear(), so anything built on the text knows to start over
+  std::size_t generation() const { return Generation; }
+
+private:
+  enum class EscapeState { None, Escape, Csi, Osc, Charset };
+
+  void put(char C);
+  void newline();
+  void runCsi(char Final);
+  std::size_t lineEnd() const;
+  void resizeLine(std::size_t Size);
+
+  std::string Text;
+  std::vector<std::size_t> Lines{0}; // Start of every line
+  std::size_t Top = 0;               // First line the cursor can still reach
+  std::size_t Row = 0;               // Line of the cursor
+  std::size_t Cursor = 0;            // Column (in bytes) inside the current line
+  EscapeState State = EscapeState::None;
+  std::string Params;
+  std::size_t Generation = 0;
+  std::size_t Rewinds = 0;
+};
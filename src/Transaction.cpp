@@ -0,0 +1,287 @@
+#include "Transaction.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <sstream>
+
+using namespace std::chrono;
+
+// Weight given to the newest run when blending it into the history
+static constexpr double HistoryWeight = 0.5;
+
+static constexpr std::array<Phase, 7> AllPhases = {Phase::Sync,    Phase::Download, Phase::Keys,    Phase::Integrity,
+                                                   Phase::Install, Phase::Hooks,    Phase::AurBuild};
+
+const char *phaseName(Phase Kind) {
+  switch (Kind) {
+  case Phase::Sync: return "sync";
+  case Phase::Download: return "download";
+  case Phase::Keys: return "keys";
+  case Phase::Integrity: return "integrity";
+  case Phase::Install: return "install";
+  case Phase::Hooks: return "hooks";
+  case Phase::AurBuild: return "aur-build";
+  }
+  return "unknown";
+}
+
+static std::string historyPath() { return cacheDir() + "/timings"; }
+
+static std::string stepKey(Phase Kind, std::string_view Name) { return std::format("{}/{}", phaseName(Kind), Name); }
+
+static double secondsBetween(Clock::time_point From, Clock::time_point To) { return duration<double>(To - From).count(); }
+
+TimingHistory loadTimingHistory() {
+  TimingHistory History;
+  std::ifstream File(historyPath());
+  std::string Line;
+  while (std::getline(File, Line)) {
+    // "phase <seconds> <name>" or "step <seconds> <phase>/<name>"; hook names contain spaces
+    std::istringstream Fields(Line);
+    std::string Type, Key;
+    double Seconds = 0;
+    if (!(Fields >> Type >> Seconds >> std::ws) || !std::getline(Fields, Key) || Key.empty()) continue;
+    if (Type == "phase") History.PhaseSeconds[Key] = Seconds;
+    if (Type == "step") History.StepSeconds[Key] = Seconds;
+  }
+  return History;
+}
+
+void saveTimingHistory(const TimingHistory &History) {
+  std::ofstream File(historyPath());
+  for (const auto &[Key, Seconds] : History.PhaseSeconds) {
+    File << std::format("phase {:.2f} {}\n", Seconds, Key);
+  }
+  for (const auto &[Key, Seconds] : History.StepSeconds) {
+    File << std::format("step {:.2f} {}\n", Seconds, Key);
+  }
+}
+
+// Splits "(3/12) upgrading foo" into 3, 12 and "upgrading foo"
+static bool parseCounter(std::string_view Line, int &Index, int &Total, std::string_view &Rest) {
+  if (!Line.starts_with('(')) return false;
+  std::size_t Slash = Line.find('/');
+  std::size_t Close = Line.find(") ");
+  if (Slash == std::string_view::npos || Close == std::string_view::npos || Slash > Close) return false;
+  if (std::from_chars(Line.data() + 1, Line.data() + Slash, Index).ec != std::errc{}) return false;
+  if (std::from_chars(Line.data() + Slash + 1, Line.data() + Close, Total).ec != std::errc{}) return false;
+  Rest = Line.substr(Close + 2);
+  return true;
+}
+
+// First whitespace separated word
+static std::string_view firstWord(std::string_view Text) {
+  std::size_t End = Text.find_first_of(" \t");
+  return Text.substr(0, End);
+}
+
+void TransactionParser::reset(const std::vector<PackageUpdate> &PendingUpdates, Clock::time_point Now) {
+  Phases.clear();
+  Steps.clear();
+  Pending = PendingUpdates;
+  History = loadTimingHistory();
+  Started = Now;
+  ParsedOffset = 0;
+  ParsedRows = 0;
+  Counter = 0;
+  CounterTotal = 0;
+  Active = true;
+}
+
+void TransactionParser::update(const TerminalBuffer &Output, Clock::time_point Now) {
+  if (!Active) return;
+  const std::string &Text = Output.text();
+  if (Output.generation() != Generation) {
+    // The buffer was cleared underneath us
+    Generation = Output.generation();
+    ParsedOffset = 0;
+    ParsedRows = 0;
+  } else if (Output.rewinds() != Rewinds && ParsedRows > 0) {
+    // Lines on the screen may have been rewritten to another length since, but not added or
+    // removed: the first unparsed one is found again by counting
+    ParsedOffset = ScreenStart;
+    for (std::size_t Row = 0; Row < ParsedRows; ++Row) ParsedOffset = Text.find('\n', ParsedOffset) + 1;
+  }
+  Rewinds = Output.rewinds();
+
+  // Finished lines are parsed exactly once
+  while (ParsedOffset < Output.committedSize()) {
+    std::size_t End = Text.find('\n', ParsedOffset);
+    if (End == std::string::npos || End >= Output.committedSize()) break;
+    parseLine(std::string_view(Text).substr(ParsedOffset, End - ParsedOffset), Now);
+    ParsedOffset = End + 1;
+  }
+  ScreenStart = Output.screenStart();
+  ParsedRows = ParsedOffset > ScreenStart ? std::count(Text.begin() + ScreenStart, Text.begin() + ParsedOffset, '\n') : 0;
+
+  // The line being redrawn tells us early when a package or hook starts
+  if (Output.committedSize() < Text.size()) {
+    std::string_view Current = std::string_view(Text).substr(Output.committedSize());
+    parseLine(Current.substr(0, Current.find('\n')), Now);
+  }
+}
+
+void TransactionParser::parseLine(std::string_view Line, Clock::time_point Now) {
+  std::size_t First = Line.find_first_not_of(' ');
+  if (First == std::string_view::npos) return;
+  Line.remove_prefix(First);
+
+  if (Line.starts_with(":: ")) {
+    std::string_view Header = Line.substr(3);
+    if (Header.starts_with("Synchroni")) {
+      startPhase(Phase::Sync, Now);
+    } else if (Header.starts_with("Retrieving packages")) {
+      startPhase(Phase::Download, Now);
+    } else if (Header.starts_with("Processing package changes")) {
+      startPhase(Phase::Install, Now);
+    } else if (Header.starts_with("Running pre-transaction hooks") || Header.starts_with("Running post-transaction hooks")) {
+      startPhase(Phase::Hooks, Now);
+    } else if (Header.starts_with("Starting full system upgrade") || Header.starts_with("Resolving dependencies") ||
+               Header.starts_with("Calculating conflicts")) {
+      // Dependency resolution belongs to no phase
+      closePhase(Now);
+    }
+    return;
+  }
+
+  if (Line.starts_with("==> Making package: ")) {
+    startPhase(Phase::AurBuild, Now);
+    startStep(Phase::AurBuild, firstWord(Line.substr(20)), Now);
+    return;
+  }
+  if (Line.starts_with("==> Finished making: ")) {
+    closeStep(Now);
+    return;
+  }
+
+  int Index = 0, Total = 0;
+  std::string_view Rest;
+  if (!parseCounter(Line, Index, Total, Rest)) return;
+
+  if (Rest.starts_with("checking keys in keyring") || Rest.starts_with("downloading required keys")) {
+    startPhase(Phase::Keys, Now);
+  } else if (Rest.starts_with("checking package integrity") || Rest.starts_with("loading package files") ||
+             Rest.starts_with("checking for file conflicts") || Rest.starts_with("checking available disk space")) {
+    startPhase(Phase::Integrity, Now);
+  } else if (!Phases.empty() && !Phases.back().Finished && Phases.back().Kind == Phase::Install) {
+    // "(1/12) upgrading foo", "(2/12) installing bar", "(3/12) removing baz", ...
+    std::string_view Name = firstWord(Rest.substr(std::min(Rest.size(), firstWord(Rest).size() + 1)));
+    Counter = Index;
+    CounterTotal = Total;
+    startStep(Phase::Install, Name, Now);
+  } else if (!Phases.empty() && !Phases.back().Finished && Phases.back().Kind == Phase::Hooks) {
+    // "(1/5) Arming ConditionNeedsUpdate..."
+    std::string_view Name = Rest.substr(0, Rest.find("..."));
+    startStep(Phase::Hooks, Name, Now);
+  }
+}
+
+void TransactionParser::startPhase(Phase Kind, Clock::time_point Now) {
+  if (!Phases.empty() && !Phases.back().Finished && Phases.back().Kind == Kind) return;
+  closePhase(Now);
+  Phases.push_back({Kind, Now, Now, false});
+}
+
+void TransactionParser::closePhase(Clock::time_point Now) {
+  closeStep(Now);
+  if (!Phases.empty() && !Phases.back().Finished) {
+    Phases.back().End = Now;
+    Phases.back().Finished = true;
+  }
+}
+
+void TransactionParser::startStep(Phase Kind, std::string_view Name, Clock::time_point Now) {
+  if (Name.empty()) return;
+  // The same line is seen while it is being redrawn and again when it is finished
+  if (!Steps.empty() && !Steps.back().Finished && Steps.back().Kind == Kind && Steps.back().Name == Name) return;
+  closeStep(Now);
+  Steps.push_back({Kind, std::string(Name), Now, Now, false});
+}
+
+void TransactionParser::closeStep(Clock::time_point Now) {
+  if (!Steps.empty() && !Steps.back().Finished) {
+    Steps.back().End = Now;
+    Steps.back().Finished = true;
+  }
+}
+
+void TransactionParser::finish(Clock::time_point Now, bool Success) {
+  if (!Active) return;
+  closePhase(Now);
+  Active = false;
+  if (!Success) return;
+
+  // Blend this run into the history; phases that appear several times are summed
+  std::map<std::string, double> PhaseTotals;
+  for (const PhaseTiming &Timing : Phases) {
+    PhaseTotals[phaseName(Timing.Kind)] += secondsBetween(Timing.Start, Timing.End);
+  }
+  // Phases this run skipped (nothing to download, no hooks) say nothing about their usual length
+  for (const auto &[Name, Seconds] : PhaseTotals) {
+    auto [It, Inserted] = History.PhaseSeconds.try_emplace(Name, Seconds);
+    if (!Inserted) It->second = HistoryWeight * Seconds + (1.0 - HistoryWeight) * It->second;
+  }
+  for (const StepTiming &Timing : Steps) {
+    double Seconds = secondsBetween(Timing.Start, Timing.End);
+    auto [It, Inserted] = History.StepSeconds.try_emplace(stepKey(Timing.Kind, Timing.Name), Seconds);
+    if (!Inserted) It->second = HistoryWeight * Seconds + (1.0 - HistoryWeight) * It->second;
+  }
+  saveTimingHistory(History);
+}
+
+double TransactionParser::expectedSeconds(Phase Kind) const {
+  // Package related phases scale with what is pending now, the rest is taken as is
+  if (Kind == Phase::Install || Kind == Phase::AurBuild) {
+    double Known = 0;
+    int KnownCount = 0;
+    for (const PackageUpdate &Update : Pending) {
+      if (auto It = History.StepSeconds.find(stepKey(Kind, Update.Name)); It != History.StepSeconds.end()) {
+        Known += It->second;
+        KnownCount++;
+      }
+    }
+    if (Kind == Phase::AurBuild) return Known;
+    if (KnownCount > 0) {
+      // Packages never seen before are assumed to take the average time
+      return Known + (Known / KnownCount) * (static_cast<double>(Pending.size()) - KnownCount);
+    }
+  }
+  auto It = History.PhaseSeconds.find(phaseName(Kind));
+  return It != History.PhaseSeconds.end() ? It->second : 0.0;
+}
+
+double TransactionParser::remainingSeconds(Clock::time_point Now) const {
+  std::optional<Phase> Current;
+  if (!Phases.empty() && !Phases.back().Finished) Current = Phases.back().Kind;
+
+  double Remaining = 0;
+  for (Phase Kind : AllPhases) {
+    bool Seen = std::ranges::any_of(Phases, [Kind](const PhaseTiming &Timing) { return Timing.Kind == Kind; });
+    if (Current == Kind) {
+      const PhaseTiming &Timing = Phases.back();
+      Remaining += std::max(0.0, expectedSeconds(Kind) - secondsBetween(Timing.Start, Now));
+    } else if (!Seen) {
+      Remaining += expectedSeconds(Kind);
+    }
+  }
+  return Remaining;
+}
+
+float TransactionParser::progress(Clock::time_point Now) const {
+  if (!Active) return Phases.empty() ? 0.0f : 1.0f;
+  if (!History.PhaseSeconds.empty()) {
+    double Elapsed = secondsBetween(Started, Now);
+    double Remaining = remainingSeconds(Now);
+    if (Elapsed + Remaining > 0) return static_cast<float>(Elapsed / (Elapsed + Remaining));
+  }
+  // No history yet: fall back to the install counter
+  return CounterTotal > 0 ? static_cast<float>(Counter) / CounterTotal : 0.0f;
+}
+
+std::optional<seconds> TransactionParser::eta(Clock::time_point Now) const {
+  if (!Active || History.PhaseSeconds.empty()) return std::nullopt;
+  return duration_cast<seconds>(duration<double>(remainingSeconds(Now)));
+}
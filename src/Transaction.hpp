@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Terminal.hpp"
+#include "Updates.hpp"
+#include <chrono>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+enum class Phase { Sync, Download, Keys, Integrity, Install, Hooks, AurBuild };
+
+const char *phaseName(Phase Kind);
+
+struct PhaseTiming {
+  Phase Kind;
+  Clock::time_point Start;
+  Clock::time_point End;
+  bool Finished = false;
+};
+
+// One package being installed/upgraded, one hook, or one AUR build
+struct StepTiming {
+  Phase Kind;
+  std::string Name;
+  Clock::time_point Start;
+  Clock::time_point End;
+  bool Finished = false;
+};
+
+// Durations of previous runs, used for the ETA
+struct TimingHistory {
+  std::map<std::string, double> PhaseSeconds;
+  std::map<std::string, double> StepSeconds; // Keyed by "<phase>/<name>"
+};
+
+// Parses the output of "paru -Syu" incrementally while it is streamed
+class TransactionParser {
+public:
+  void reset(const std::vector<PackageUpdate> &Pending, Clock::time_point Now);
+  void update(const TerminalBuffer &Output, Clock::time_point Now);
+  void finish(Clock::time_point Now, bool Success);
+
+  const std::vector<PhaseTiming> &phases() const { return Phases; }
+  const std::vector<StepTiming> &steps() const { return Steps; }
+  bool active() const { return Active; }
+
+  // Fraction of the update done, in [0, 1]
+  float progress(Clock::time_point Now) const;
+  // Remaining time, only known when previous runs have been recorded
+  std::optional<std::chrono::seconds> eta(Clock::time_point Now) const;
+
+private:
+  void parseLine(std::string_view Line, Clock::time_point Now);
+  void startPhase(Phase Kind, Clock::time_point Now);
+  void closePhase(Clock::time_point Now);
+  void startStep(Phase Kind, std::string_view Name, Clock::time_point Now);
+  void closeStep(Clock::time_point Now);
+  double expectedSeconds(Phase Kind) const;
+  double remainingSeconds(Clock::time_point Now) const;
+
+  std::vector<PhaseTiming> Phases;
+  std::vector<StepTiming> Steps;
+  std::vector<PackageUpdate> Pending;
+  TimingHistory History;
+  Clock::time_point Started;
+  std::size_t ParsedOffset = 0;
+  std::size_t Generation = 0;  // Of the output buffer, to notice a clear()
+  std::size_t Rewinds = 0;     // Of the output buffer, to notice lines being rewritten
+  std::size_t ScreenStart = 0; // Output.screenStart() as of the last update
+  std::size_t ParsedRows = 0;  // Parsed lines at and after ScreenStart
+  int Counter = 0; // "(x/y)" of the latest install line
+  int CounterTotal = 0;
+  bool Active = false;
+};
+
+TimingHistory loadTimingHistory();
+void saveTimingHistory(const TimingHistory &History);
@@ -6,18 +6,34 @@
 #include "imgui_impl_opengl3.h"
 #include "tray.hpp"
 #include "Updates.hpp"
+#include "Pty.hpp"
+#include "Terminal.hpp"
+#include "Transaction.hpp"
+#include "Config.hpp"
+#include "Prefetch.hpp"
+#include "AurScheduler.hpp"
+#include "Mirrors.hpp"
+#include "PacmanConf.hpp"
+#include "Fleet.hpp"
+#include "LogIndex.hpp"
+#include "Instance.hpp"
+#include "Render.hpp"
 
 #include <iostream>
 #include <format>
 #include <filesystem>
 #include <random>
 #include <fstream>
-#include <regex>
-#include <fcntl.h>
 #include <unistd.h>
-#include <memory>
-#include <array>
 #include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <array>
+#include <optional>
+#include <future>
+#include <thread>
+#include <ctime>
 
 namespace fs = std::filesystem;
 
@@ -26,6 +42,10 @@ static bool g_WindowVisible = true;
 static bool g_ShouldRefresh = false;
 static bool g_ShouldClose = false;
 static int g_UpdateCount = 0;
+static FrameSkipper g_Frames; // Last presented frame, for the low-overhead render mode
+
+// How long the low-overhead mode sleeps between frames when nothing is going on
+static constexpr double IdleWait = 0.25;
 
 void cb_toggle_ui(struct tray *tray) {
   if (g_WindowVisible) {
@@ -56,6 +76,13 @@ static struct tray tray_struct = {
 };
 
 void updateTrayIcon(int count) {
+  // The icon only shows the count, so there is nothing to redraw when that is unchanged
+  static int IconCount = -1;
+  if (count == IconCount) {
+    return;
+  }
+  IconCount = count;
+
   std::ofstream out("/tmp/imupdate_icon.svg");
   std::string color = count > 0 ? "red" : "green";
   out << std::format(
@@ -65,7 +92,290 @@ void updateTrayIcon(int count) {
   tray_update(&tray_struct);
 }
 
-void showUpdateGui(bool runInTray) {
+static std::string formatDuration(double Seconds) {
+  int Total = static_cast<int>(Seconds);
+  return Total >= 60 ? std::format("{}m {:02}s", Total / 60, Total % 60) : std::format("{:.1f}s", Seconds);
+}
+
+// Overall progress bar plus per-phase and per-package timings of the current/last run
+static void drawTransactionTimings(const TransactionParser &Transaction) {
+  if (Transaction.phases().empty() && !Transaction.active()) return;
+  Clock::time_point Now = Clock::now();
+  auto SecondsOf = [Now](Clock::time_point Start, Clock::time_point End, bool Finished) {
+    return std::chrono::duration<double>((Finished ? End : Now) - Start).count();
+  };
+
+  std::string Overlay;
+  if (!Transaction.active()) {
+    Overlay = "Done";
+  } else {
+    Overlay = Transaction.phases().empty() || Transaction.phases().back().Finished ? "Working"
+                                                                                     : phaseName(Transaction.phases().back().Kind);
+    if (auto Eta = Transaction.eta(Now)) Overlay += std::format(" - ETA {}", formatDuration(Eta->count()));
+  }
+  ImGui::ProgressBar(Transaction.progress(Now), ImVec2(-FLT_MIN, 0), Overlay.c_str());
+
+  if (!ImGui::CollapsingHeader("Timings")) return;
+
+  if (ImGui::BeginTable("Phases", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchProp)) {
+    ImGui::TableSetupColumn("Phase");
+    ImGui::TableSetupColumn("Duration");
+    ImGui::TableHeadersRow();
+    for (const PhaseTiming &Timing : Transaction.phases()) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(phaseName(Timing.Kind));
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(formatDuration(SecondsOf(Timing.Start, Timing.End, Timing.Finished)).c_str());
+    }
+    ImGui::EndTable();
+  }
+
+  // Slowest packages, hooks and builds first: those are the ones worth looking at
+  std::vector<const StepTiming *> Sorted;
+  for (const StepTiming &Timing : Transaction.steps()) Sorted.push_back(&Timing);
+  std::ranges::sort(Sorted, std::greater{}, [&](const StepTiming *Timing) { return SecondsOf(Timing->Start, Timing->End, Timing->Finished); });
+
+  if (ImGui::BeginTable("Steps", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp,
+                        ImVec2(0, ImGui::GetTextLineHeightWithSpacing() * 8))) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Step");
+    ImGui::TableSetupColumn("Phase");
+    ImGui::TableSetupColumn("Duration");
+    ImGui::TableHeadersRow();
+    for (const StepTiming *Timing : Sorted) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(Timing->Name.c_str());
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(phaseName(Timing->Kind));
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(formatDuration(SecondsOf(Timing->Start, Timing->End, Timing->Finished)).c_str());
+    }
+    ImGui::EndTable();
+  }
+}
+
+// Searchable state of the live log view
+struct LogView {
+  static constexpr std::size_t None = SIZE_MAX;
+  std::array<char, 256> Query{};
+  std::size_t Current = None;         // Selected match
+  std::size_t ProblemLine = None;     // Last error/warning line jumped to
+  std::optional<std::size_t> JumpTo;  // Line to scroll to on the next frame
+  float VisibleFrom = 0.0f;           // Part of the log on screen, as fractions of its height
+  float VisibleTo = 1.0f;
+};
+
+static constexpr float MinimapWidth = 14.0f;
+
+// Marks error/warning lines and query matches behind the visible part of the log text
+static void drawLogHighlights(const LogIndex &Index, const LogView &View, const std::string &Text, ImVec2 Origin,
+                              float Width) {
+  float LineHeight = ImGui::GetTextLineHeight();
+  std::size_t First = static_cast<std::size_t>(ImGui::GetScrollY() / LineHeight);
+  std::size_t End = std::min(Index.lineCount(), First + static_cast<std::size_t>(ImGui::GetWindowHeight() / LineHeight) + 2);
+  ImDrawList *DrawList = ImGui::GetWindowDrawList();
+
+  auto MarkLines = [&](const std::vector<std::size_t> &Lines, ImU32 Color) {
+    for (auto It = std::lower_bound(Lines.begin(), Lines.end(), First); It != Lines.end() && *It < End; ++It) {
+      float Y = Origin.y + *It * LineHeight;
+      DrawList->AddRectFilled(ImVec2(Origin.x, Y), ImVec2(Origin.x + Width, Y + LineHeight), Color);
+    }
+  };
+  MarkLines(Index.lines(Severity::Warning), IM_COL32(200, 160, 0, 60));
+  MarkLines(Index.lines(Severity::Error), IM_COL32(220, 40, 40, 70));
+
+  const std::vector<std::size_t> &Matches = Index.matches();
+  float MatchWidth = ImGui::CalcTextSize(Index.query().c_str()).x;
+  std::size_t EndOffset = Index.lineStart(End);
+  for (auto It = std::lower_bound(Matches.begin(), Matches.end(), Index.lineStart(First));
+       It != Matches.end() && *It < EndOffset; ++It) {
+    std::size_t Line = Index.lineOf(*It);
+    float X = Origin.x + ImGui::CalcTextSize(Text.data() + Index.lineStart(Line), Text.data() + *It).x;
+    float Y = Origin.y + Line * LineHeight;
+    bool Selected = static_cast<std::size_t>(It - Matches.begin()) == View.Current;
+    DrawList->AddRectFilled(ImVec2(X, Y), ImVec2(X + MatchWidth, Y + LineHeight),
+                            Selected ? IM_COL32(255, 140, 0, 200) : IM_COL32(60, 120, 255, 120));
+  }
+}
+
+// Read-only, auto-scrolling view of a command's output; with an index, also highlighted and jumpable.
+// Only the lines on screen are submitted, so a long log costs no more per frame than a short one.
+static void drawOutputRegion(const char *Id, const TerminalBuffer &Output, const LogIndex *Index = nullptr,
+                             LogView *View = nullptr) {
+  ImVec2 Size(Index ? -(MinimapWidth + ImGui::GetStyle().ItemSpacing.x) : 0.0f, 0.0f);
+  ImGui::BeginChild(Id, Size, true, ImGuiWindowFlags_HorizontalScrollbar);
+
+  // Follows the end while this region's view is left at the bottom
+  bool AutoScroll = ImGui::GetScrollY() >= ImGui::GetScrollMaxY() - 1.0f;
+  // Without an index the longest line is only known from what has been on screen so far; it is kept
+  // in the child window's storage, so every region has its own
+  ImGuiStorage *Storage = ImGui::GetStateStorage();
+  ImGuiID WidestId = ImGui::GetID("Widest");
+  float Widest = Index ? (Index->longestLine() + 1) * ImGui::CalcTextSize("M").x : Storage->GetFloat(WidestId);
+
+  float LineHeight = ImGui::GetTextLineHeight();
+  std::size_t LineCount = Output.lineCount();
+  // One spare line below the last, so the end of the log is never under the horizontal scrollbar
+  float Height = (LineCount + 1) * LineHeight;
+  ImVec2 Origin = ImGui::GetCursorScreenPos();
+
+  if (Index && View) {
+    drawLogHighlights(*Index, *View, Output.text(), Origin, std::max(ImGui::GetContentRegionAvail().x, Widest));
+    if (View->JumpTo) {
+      // Put the line a third of the way down, so what led up to it is visible too
+      ImGui::SetScrollY(std::max(0.0f, *View->JumpTo * LineHeight - ImGui::GetWindowHeight() / 3.0f));
+      View->JumpTo.reset();
+      AutoScroll = false;
+    }
+    View->VisibleFrom = ImGui::GetScrollY() / Height;
+    View->VisibleTo = std::min(1.0f, (ImGui::GetScrollY() + ImGui::GetWindowHeight()) / Height);
+  }
+
+  // No spacing between lines, so line N is at N * LineHeight like the highlights assume
+  ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(ImGui::GetStyle().ItemSpacing.x, 0.0f));
+  ImGuiListClipper Clipper;
+  Clipper.Begin(static_cast<int>(LineCount), LineHeight);
+  while (Clipper.Step()) {
+    for (int I = Clipper.DisplayStart; I < Clipper.DisplayEnd; ++I) {
+      std::string_view Line = Output.line(I);
+      ImGui::TextUnformatted(Line.data(), Line.data() + Line.size());
+      if (!Index) Widest = std::max(Widest, ImGui::GetItemRectSize().x);
+    }
+  }
+  ImGui::Dummy(ImVec2(Widest, LineHeight));
+  ImGui::PopStyleVar();
+
+  if (ImGui::BeginPopupContextWindow()) {
+    if (ImGui::MenuItem("Copy all")) ImGui::SetClipboardText(Output.text().c_str());
+    ImGui::EndPopup();
+  }
+
+  if (AutoScroll) {
+    ImGui::SetScrollHereY(1.0f);
+  }
+  Storage->SetFloat(WidestId, Widest);
+
+  ImGui::EndChild();
+}
+
+// Strip next to the log: errors and warnings on the left, query matches on the right, click to jump
+static void drawLogMinimap(const LogIndex &Index, LogView &View) {
+  ImGui::SameLine();
+  ImVec2 Pos = ImGui::GetCursorScreenPos();
+  ImVec2 Size(MinimapWidth, std::max(1.0f, ImGui::GetContentRegionAvail().y));
+  ImGui::InvisibleButton("##minimap", Size);
+  std::size_t Lines = Index.lineCount();
+  if (ImGui::IsItemActive()) {
+    float Fraction = std::clamp((ImGui::GetIO().MousePos.y - Pos.y) / Size.y, 0.0f, 1.0f);
+    View.JumpTo = static_cast<std::size_t>(Fraction * (Lines - 1));
+  }
+
+  ImDrawList *DrawList = ImGui::GetWindowDrawList();
+  DrawList->AddRectFilled(Pos, ImVec2(Pos.x + Size.x, Pos.y + Size.y), IM_COL32(255, 255, 255, 15));
+
+  auto Contains = [](const std::vector<std::size_t> &Sorted, std::size_t From, std::size_t To) {
+    auto It = std::lower_bound(Sorted.begin(), Sorted.end(), From);
+    return It != Sorted.end() && *It < To;
+  };
+  // One slice of the log per pixel row, looked up with binary searches, so the cost doesn't grow with the hits
+  float Half = Size.x / 2.0f;
+  int Rows = static_cast<int>(Size.y);
+  for (int Row = 0; Row < Rows; ++Row) {
+    std::size_t From = Row * Lines / Rows;
+    std::size_t To = std::max(From + 1, (Row + 1) * Lines / Rows);
+    float Y = Pos.y + Row;
+    if (Contains(Index.lines(Severity::Error), From, To)) {
+      DrawList->AddRectFilled(ImVec2(Pos.x, Y), ImVec2(Pos.x + Half, Y + 1.0f), IM_COL32(230, 50, 50, 255));
+    } else if (Contains(Index.lines(Severity::Warning), From, To)) {
+      DrawList->AddRectFilled(ImVec2(Pos.x, Y), ImVec2(Pos.x + Half, Y + 1.0f), IM_COL32(230, 180, 0, 255));
+    }
+    if (Contains(Index.matches(), Index.lineStart(From), Index.lineStart(To))) {
+      DrawList->AddRectFilled(ImVec2(Pos.x + Half, Y), ImVec2(Pos.x + Size.x, Y + 1.0f), IM_COL32(80, 140, 255, 255));
+    }
+  }
+  DrawList->AddRect(ImVec2(Pos.x, Pos.y + View.VisibleFrom * Size.y), ImVec2(Pos.x + Size.x, Pos.y + View.VisibleTo * Size.y),
+                    IM_COL32(255, 255, 255, 120));
+}
+
+// Live update log with search, error/warning navigation and a minimap
+static void drawLogView(const char *Id, const TerminalBuffer &Output, LogIndex &Index, LogView &View) {
+  Index.update();
+
+  ImGui::SetNextItemWidth(ImGui::GetFontSize() * 16.0f);
+  bool Submitted = ImGui::InputTextWithHint("##search", "Search log", View.Query.data(), View.Query.size(),
+                                            ImGuiInputTextFlags_EnterReturnsTrue);
+  if (Submitted) ImGui::SetKeyboardFocusHere(-1); // Keep typing after Enter
+  if (std::string_view(View.Query.data()) != Index.query()) {
+    Index.setQuery(View.Query.data());
+    View.Current = LogView::None;
+  }
+
+  const std::vector<std::size_t> &Matches = Index.matches();
+  ImGui::SameLine();
+  bool Previous = ImGui::ArrowButton("##previous", ImGuiDir_Up);
+  ImGui::SameLine();
+  bool Next = ImGui::ArrowButton("##next", ImGuiDir_Down) || Submitted;
+  if (!Matches.empty() && (Previous || Next)) {
+    std::size_t Count = Matches.size();
+    if (View.Current >= Count) {
+      View.Current = Next ? 0 : Count - 1;
+    } else {
+      View.Current = Next ? (View.Current + 1) % Count : (View.Current + Count - 1) % Count;
+    }
+    View.JumpTo = Index.lineOf(Matches[View.Current]);
+  }
+  if (!Index.query().empty()) {
+    ImGui::SameLine();
+    std::string Status = Matches.empty()               ? std::string("No matches")
+                         : View.Current < Matches.size() ? std::format("{}/{}", View.Current + 1, Matches.size())
+                                                         : std::format("{} matches", Matches.size());
+    ImGui::TextUnformatted(Status.c_str());
+  }
+
+  // Cycles through the lines of one severity, starting after the last one jumped to
+  auto JumpButton = [&](const char *Label, Severity Level, ImVec4 Color) {
+    const std::vector<std::size_t> &Lines = Index.lines(Level);
+    ImGui::SameLine();
+    ImGui::PushStyleColor(ImGuiCol_Text, Lines.empty() ? ImGui::GetStyle().Colors[ImGuiCol_TextDisabled] : Color);
+    bool Pressed = ImGui::Button(std::format("{} {}##{}", Lines.size(), Label, Label).c_str());
+    ImGui::PopStyleColor();
+    if (Pressed && !Lines.empty()) {
+      auto It = std::upper_bound(Lines.begin(), Lines.end(), View.ProblemLine);
+      if (View.ProblemLine == LogView::None || It == Lines.end()) It = Lines.begin();
+      View.ProblemLine = *It;
+      View.JumpTo = *It;
+    }
+  };
+  JumpButton("errors", Severity::Error, ImVec4(1.0f, 0.35f, 0.35f, 1.0f));
+  JumpButton("warnings", Severity::Warning, ImVec4(1.0f, 0.8f, 0.2f, 1.0f));
+
+  drawOutputRegion(Id, Output, &Index, &View);
+  drawLogMinimap(Index, View);
+}
+
+// Pending updates, with the ones the user hasn't seen yet highlighted
+static void drawUpdateList(const std::vector<PackageUpdate> &Updates, const std::set<std::string> &NewNames) {
+  ImGui::BeginChild("OutputRegion", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
+  ImGuiListClipper Clipper;
+  Clipper.Begin(static_cast<int>(Updates.size()));
+  while (Clipper.Step()) {
+    for (int I = Clipper.DisplayStart; I < Clipper.DisplayEnd; ++I) {
+      const PackageUpdate &Update = Updates[I];
+      std::string Line = std::format("{} {} -> {}", Update.Name, Update.OldVersion, Update.NewVersion);
+      if (NewNames.contains(Update.Name)) {
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "%s  (new)", Line.c_str());
+      } else {
+        ImGui::TextUnformatted(Line.c_str());
+      }
+    }
+  }
+  ImGui::EndChild();
+}
+
+// Window, GL context and ImGui setup shared by the update and fleet views
+static GLFWwindow *createWindow(const char *Title) {
   // --- 1. Initialize GLFW ---
   if (!glfwInit()) {
     std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -80,7 +390,7 @@ void showUpdateGui(bool runInTray) {
   glfwWindowHint(GLFW_FLOATING, GLFW_TRUE);
 
   // --- 2. Create Window ---
-  GLFWwindow *Window = glfwCreateWindow(800, 600, "Update Manager", nullptr, nullptr);
+  GLFWwindow *Window = glfwCreateWindow(800, 600, Title, nullptr, nullptr);
   if (Window == nullptr) {
     std::cerr << "Failed to create GLFW window" << std::endl;
     glfwTerminate();
@@ -88,8 +398,8 @@ void showUpdateGui(bool runInTray) {
   }
   glfwMakeContextCurrent(Window);
   glfwSwapInterval(1); // Enable VSync
-  g_Window = Window;
-  g_WindowVisible = !runInTray;
+  // Exposed or damaged contents have to be drawn again even if the frame itself is unchanged
+  glfwSetWindowRefreshCallback(Window, [](GLFWwindow *) { g_Frames.invalidate(); });
 
   // --- 3. Initialize ImGui ---
   ImGui::CreateContext();
@@ -107,30 +417,126 @@ void showUpdateGui(bool runInTray) {
   ImGui::StyleColorsDark();
   ImGui_ImplGlfw_InitForOpenGL(Window, true);
   ImGui_ImplOpenGL3_Init("#version 330");
+  return Window;
+}
+
+// With a skipper, a frame identical to the one on screen is not drawn; returns whether it was
+static bool renderFrame(GLFWwindow *Window, FrameSkipper *Skipper = nullptr) {
+  ImGui::Render();
+  if (Skipper && !Skipper->needsPresent(ImGui::GetDrawData())) {
+    return false;
+  }
+
+  int DisplayW, DisplayH;
+  glfwGetFramebufferSize(Window, &DisplayW, &DisplayH);
+  glViewport(0, 0, DisplayW, DisplayH);
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+  glfwSwapBuffers(Window);
+  return true;
+}
+
+static void destroyWindow(GLFWwindow *Window) {
+  ImGui_ImplOpenGL3_Shutdown();
+  ImGui_ImplGlfw_Shutdown();
+  ImGui::DestroyContext();
+  glfwDestroyWindow(Window);
+  glfwTerminate();
+}
+
+void showUpdateGui(bool runInTray) {
+  // --- 1-3. Create the window and initialize ImGui ---
+  GLFWwindow *Window = createWindow("Update Manager");
+  ImGuiIO &io = ImGui::GetIO();
+  g_Window = Window;
+  g_WindowVisible = !runInTray;
 
   // --- 4. Load Initial Update List ---
   std::string InitialUpdateList = readFile("/tmp/updates_list");
+  std::vector<PackageUpdate> CurrentUpdates = parseUpdateList(InitialUpdateList);
+  sortUpdates(CurrentUpdates);
+
+  // What the user has already looked at, to highlight what is new since then
+  std::string SeenPath = cacheDir() + "/seen_updates";
+  std::vector<PackageUpdate> SeenUpdates = parseUpdateList(readFile(SeenPath));
+  sortUpdates(SeenUpdates);
+  std::set<std::string> NewNames;
+  auto MarkNew = [&]() {
+    UpdateDelta Delta = diffUpdates(SeenUpdates, CurrentUpdates);
+    NewNames.clear();
+    for (const PackageUpdate &Update : Delta.Added) NewNames.insert(Update.Name);
+    for (const PackageUpdate &Update : Delta.Bumped) NewNames.insert(Update.Name);
+  };
+  auto AcknowledgeNew = [&]() {
+    if (NewNames.empty()) return;
+    SeenUpdates = CurrentUpdates;
+    NewNames.clear();
+    std::ofstream(SeenPath) << formatUpdateList(SeenUpdates);
+  };
+  MarkNew();
 
   // --- 5. GUI State Variables ---
-  static std::string LiveOutputBuffer = ""; // Buffer for the live output
-  static std::unique_ptr<FILE, PipeDeleter> UpdatePipe(nullptr);
+  static TerminalBuffer LiveOutput;   // Terminal model of the live output
+  static LogIndex LiveIndex(LiveOutput, getConfig().HighlightErrors, getConfig().HighlightWarnings);
+  static LogView LiveView;            // Search and scroll state of the live output
+  static PtyProcess UpdateProc;       // Update command running inside a pty
   static bool UpdateRunning = false;  // Is the update in progress?
-  static int PipeFD = -1;             // File Descriptor of the output pipe
+  static TransactionParser Transaction; // Phases and timings parsed from the live output
+  static PtyProcess PrefetchProc;     // Background download of pending repo packages
+  static CacheSummary Cached;         // How much of the update is already downloaded
+  static Clock::time_point LastCacheScan;
+  static AurScheduler AurBuilds;      // Parallel AUR builds after the repo upgrade
+  static std::string AurPassword;     // Handed to the AUR builds once the repo upgrade is done
+  static bool UpdateCancelled = false;
+  static std::string FastestMirror = getConfig().MirrorProbe ? bestMirror() : ""; // Re-read after each probe
+  static std::future<void> MirrorRanking; // Mirror probe running after a check
+  static bool CheckFailed = false;        // The last check couldn't download the sync DBs
 
   // Keep track of the temp file to ensure deletion
   static std::string CurrentTempFile = "";
 
+  // pacman is writing packages or running hooks: interrupting it now leaves a partial upgrade
+  auto Committing = [&]() {
+    const std::vector<PhaseTiming> &Phases = Transaction.phases();
+    return !Phases.empty() && !Phases.back().Finished &&
+           (Phases.back().Kind == Phase::Install || Phases.back().Kind == Phase::Hooks);
+  };
+
+  // Pre-download what the last check found, unless an update is already running
+  auto StartPrefetch = [&]() {
+    if (!getConfig().Prefetch || PrefetchProc.active() || UpdateRunning) return;
+    startPrefetch(PrefetchProc);
+    Cached = summarizeCache();
+    LastCacheScan = Clock::now();
+  };
+  StartPrefetch();
+
+  g_UpdateCount = getLineCount("/tmp/updates_list");
   if (runInTray) {
-    g_UpdateCount = getLineCount("/tmp/updates_list");
     glfwHideWindow(Window);
     g_WindowVisible = false;
     tray_init(&tray_struct);
     updateTrayIcon(g_UpdateCount);
   }
 
+  bool WasVisible = g_WindowVisible;
+
+  // On software GL: sleep until input arrives, cap the frame rate while output streams, skip unchanged frames
+  const bool LowOverhead = lowOverheadRendering();
+  const double StreamWait = 1.0 / getConfig().StreamFps;
+  bool Settling = true; // The last frame changed something, and ImGui may need another one to settle
+
   // --- 6. Main Application Loop ---
   while (!glfwWindowShouldClose(Window)) {
-    glfwPollEvents();
+    if (LowOverhead && g_WindowVisible) {
+      bool Streaming = UpdateProc.active() || AurBuilds.running();
+      glfwWaitEventsTimeout(Streaming || Settling ? StreamWait : IdleWait);
+    } else {
+      glfwPollEvents();
+    }
 
     if (runInTray) {
       if (tray_loop(0) == -1) break; // Non-blocking tray loop
@@ -140,52 +546,88 @@ void showUpdateGui(bool runInTray) {
       break;
     }
 
+    // Requests from later launches, answered by this warm process
+    pollInstance([&](std::string_view Request) -> std::string {
+      if (Request == "show") {
+        glfwShowWindow(Window);
+        glfwFocusWindow(Window);
+        g_WindowVisible = true;
+      } else if (Request == "refresh") {
+        g_ShouldRefresh = true;
+      } else if (Request == "count") {
+        return std::format("{}\n", g_UpdateCount);
+      } else if (Request != "ping") {
+        return "unknown request\n";
+      }
+      return "ok\n";
+    });
+
     if (g_ShouldRefresh) {
       g_ShouldRefresh = false;
-      checkUpdates(false);
+      // Only what changed since this window last looked is pushed on. The file may have been rewritten
+      // by another check in between (-refresh, another instance), so it is always read back and diffed.
+      CheckFailed = !checkUpdates(false);
       InitialUpdateList = readFile("/tmp/updates_list");
-      LiveOutputBuffer = ""; // Reset live buffer to show new updates
-      g_UpdateCount = getLineCount("/tmp/updates_list");
-      updateTrayIcon(g_UpdateCount);
+      std::vector<PackageUpdate> Fresh = parseUpdateList(InitialUpdateList);
+      sortUpdates(Fresh);
+      UpdateDelta Delta = diffUpdates(CurrentUpdates, Fresh);
+      CurrentUpdates = std::move(Fresh);
+      if (!Delta.empty()) {
+        if (!UpdateRunning) LiveOutput.clear(); // Reset live buffer to show new updates
+        g_UpdateCount = getLineCount("/tmp/updates_list");
+        updateTrayIcon(g_UpdateCount);
+        MarkNew();
+      }
+      // Rank mirrors for the next prefetch or update; a check never waits on their latency
+      if (getConfig().MirrorProbe && !MirrorRanking.valid()) MirrorRanking = std::async(std::launch::async, probeMirrors, false);
+      if (!Delta.Added.empty() || !Delta.Bumped.empty() || Cached.Cached < Cached.Total) StartPrefetch();
     }
 
-    if (!g_WindowVisible) {
-      // Sleep a bit to prevent high CPU usage when hidden
-      usleep(16000); // ~60fps
-      continue;
+    if (MirrorRanking.valid() && MirrorRanking.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      MirrorRanking.get();
+      FastestMirror = bestMirror();
+    }
+
+    // Whatever was on screen counts as seen once the window is hidden
+    if (WasVisible && !g_WindowVisible) AcknowledgeNew();
+    if (!WasVisible && g_WindowVisible) g_Frames.invalidate();
+    WasVisible = g_WindowVisible;
+
+    // Processes closed before they exited, like a cancelled update after a read error
+    reapPtys();
+
+    // Background prefetch keeps running while the window is hidden
+    if (PrefetchProc.active()) {
+      std::string Discarded;
+      if (readPty(PrefetchProc, Discarded) != PtyStatus::Running) {
+        closePty(PrefetchProc);
+        Cached = summarizeCache();
+      } else if (Clock::now() - LastCacheScan > std::chrono::seconds(2)) {
+        Cached = summarizeCache();
+        LastCacheScan = Clock::now();
+      }
     }
 
     // --- 6a. Check for Live Output (Non-Blocking Read) ---
-    if (UpdatePipe) {
+    // Also while hidden: a pty nobody drains blocks the update once its buffer is full
+    if (UpdateProc.active()) {
       UpdateRunning = true;
-      std::array<char, 1024> TmpBuffer;
-      // Read from the pipe non-blockingly
-      ssize_t BytesRead = read(PipeFD, TmpBuffer.data(), TmpBuffer.size() - 1);
-
-      if (BytesRead > 0) {
-        // New data arrived
-        TmpBuffer[BytesRead] = '\0';
-        std::string RawChunk = TmpBuffer.data();
+      // A cancel that hasn't taken effect yet must not end in SIGKILL once pacman commits
+      if (UpdateProc.Stopping && Committing()) holdPty(UpdateProc);
+      std::string RawChunk;
+      PtyStatus Status = readPty(UpdateProc, RawChunk);
 
-        // 1. Regex to strip ANSI escape codes (colors, cursor movements, etc.)
-        // This removes [25l, [1E, colors, etc.
-        static const std::regex AnsiRegex(R"(\x1B\[[0-9;?]*[a-zA-Z])");
-        std::string CleanChunk = std::regex_replace(RawChunk, AnsiRegex, "");
+      // The terminal model handles escape codes and lets '\r' redraw the current line
+      LiveOutput.feed(RawChunk);
+      Transaction.update(LiveOutput, Clock::now());
 
-        // 2. Remove Carriage Returns (\r) and null bytes
-        std::erase(CleanChunk, '\r');
-        std::erase(CleanChunk, '\0');
-
-        LiveOutputBuffer += CleanChunk;
-
-      } else if (BytesRead == 0) {
-        // End-of-File (EOF) - The command has finished execution.
-        FILE *RawPipe = UpdatePipe.release();
-        int ExitStatus = pclose(RawPipe);
+      if (Status == PtyStatus::Exited) {
+        // The command has finished execution.
+        int ExitStatus = closePty(UpdateProc);
+        Transaction.finish(Clock::now(), ExitStatus == 0);
 
         UpdateRunning = false;
 
-        // Ensure temp file is deleted even if the shell command failed to do so
         // Ensure temp file and token are deleted even if the shell command failed to do so
         if (!CurrentTempFile.empty()) {
           if (fs::exists(CurrentTempFile)) fs::remove(CurrentTempFile);
@@ -194,28 +636,60 @@ void showUpdateGui(bool runInTray) {
           CurrentTempFile = "";
         }
 
-        if (ExitStatus == 0) {
-          LiveOutputBuffer += "\n\n--- UPDATE FINISHED ---";
+        // With parallel AUR builds the command above only upgraded repo packages
+        std::vector<PackageUpdate> AurPending;
+        if (ExitStatus == 0 && getConfig().AurParallel) {
+          AurPending = parseUpdateList(readFile(aurUpdatesPath()));
+        }
+
+        if (UpdateCancelled) {
+          LiveOutput.feed("\n\n--- UPDATE CANCELLED ---");
+        } else if (!AurPending.empty() && AurBuilds.start(AurPending, AurPassword)) {
+          UpdateRunning = true;
+          LiveOutput.feed(std::format("\n\n--- BUILDING {} AUR PACKAGES ---", AurPending.size()));
+        } else if (ExitStatus == 0) {
+          LiveOutput.feed("\n\n--- UPDATE FINISHED ---");
         } else {
-          LiveOutputBuffer +=
-              std::format("\n\n--- UPDATE FAILED ---\n(Exit Code: {})\nPossible causes: Wrong password or network issue.", ExitStatus);
+          LiveOutput.feed(
+              std::format("\n\n--- UPDATE FAILED ---\n(Exit Code: {})\nPossible causes: Wrong password or network issue.", ExitStatus));
         }
-      } else {
-        // Error or temporarily no data
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-          LiveOutputBuffer += "\n\n--- ERROR READING PIPE ---";
-          UpdatePipe.reset();
-          UpdateRunning = false;
-          // Fallback cleanup
-          if (!CurrentTempFile.empty()) {
-            if (fs::exists(CurrentTempFile)) fs::remove(CurrentTempFile);
-            std::string UsedFile = CurrentTempFile + ".used";
-            if (fs::exists(UsedFile)) fs::remove(UsedFile);
-          }
+        std::fill(AurPassword.begin(), AurPassword.end(), '\0');
+        AurPassword.clear();
+      } else if (Status == PtyStatus::Error) {
+        LiveOutput.feed("\n\n--- ERROR READING PTY ---");
+        closePty(UpdateProc);
+        Transaction.finish(Clock::now(), false);
+        std::fill(AurPassword.begin(), AurPassword.end(), '\0');
+        AurPassword.clear();
+        UpdateRunning = false;
+        // Fallback cleanup
+        if (!CurrentTempFile.empty()) {
+          if (fs::exists(CurrentTempFile)) fs::remove(CurrentTempFile);
+          std::string UsedFile = CurrentTempFile + ".used";
+          if (fs::exists(UsedFile)) fs::remove(UsedFile);
         }
       }
     }
 
+    if (AurBuilds.running()) {
+      AurBuilds.poll();
+      if (!AurBuilds.running()) {
+        UpdateRunning = false;
+        if (AurBuilds.cancelled()) {
+          LiveOutput.feed("\n\n--- UPDATE CANCELLED ---");
+        } else {
+          LiveOutput.feed(AurBuilds.succeeded() ? "\n\n--- UPDATE FINISHED ---"
+                                                : "\n\n--- AUR BUILDS FAILED ---\nSee the build tabs for details.");
+        }
+      }
+    }
+
+    if (!g_WindowVisible) {
+      // Sleep a bit to prevent high CPU usage when hidden
+      usleep(LowOverhead ? 100000 : 16000); // ~10fps or ~60fps
+      continue;
+    }
+
     // --- 6b. Start new ImGui frame ---
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -243,8 +717,14 @@ void showUpdateGui(bool runInTray) {
 
       if (ImGui::Button("Update") || EnterPressed) {
         if (!UpdateRunning) {
-          LiveOutputBuffer = InitialUpdateList;
+          LiveOutput.clear();
+          LiveOutput.feed(InitialUpdateList);
           UpdateRunning = true;
+          UpdateCancelled = false;
+          AcknowledgeNew();
+
+          // The update downloads whatever is still missing itself; the main loop reaps the prefetch once it is gone
+          if (PrefetchProc.active()) stopPty(PrefetchProc);
 
           // 1. Generate a random temporary filename
           std::random_device RD;
@@ -268,32 +748,49 @@ void showUpdateGui(bool runInTray) {
               // Set permissions to 700 (Owner Read/Write/Execute ONLY)
               fs::permissions(CurrentTempFile, fs::perms::owner_all, fs::perm_options::replace);
             } else {
-              LiveOutputBuffer = "Error: Could not create temp password file.";
+              LiveOutput.clear();
+              LiveOutput.feed("Error: Could not create temp password file.");
               UpdateRunning = false;
             }
           }
 
           if (UpdateRunning) {
-            // Set the password as an environment variable before popen
+            // Set the password as an environment variable before spawning
             setenv("IMUPDATE_PASS", Password, 1);
 
             // 3. Construct the command
             // - export SUDO_ASKPASS: sets the helper
             // - sudo -A -v: refreshes credentials using the helper
             // - rm -f {}.used: allow the helper to run again for paru, since paru might allocate a PTY and bypass sudo cache
-            // - paru ...: runs the update
+            // - paru ...: runs the update, with progress bars since it now talks to a pty
+            // - --sudoflags -A --sudoloop: nothing ever types into the pty, so paru's own sudo calls must use the
+            //   helper too and keep the timestamp alive instead of prompting once it expires
+            // - --skipreview: the PKGBUILD review would wait for a pager to be quit
+            // - --cachedir: also picks up packages the background prefetch downloaded
             // Note: We do NOT delete the file here immediately. Cleanup happens on exit or next run.
-            std::string Cmd = std::format("{{ export SUDO_ASKPASS={0} && sudo -A -v && rm -f {0}.used && stdbuf -oL paru -Syu --noconfirm "
-                                          "--color=never --noprogressbar; }} 2>&1",
-                                          CurrentTempFile);
+            std::string CacheDirs = getConfig().Prefetch
+                                        ? std::format(" --cachedir /var/cache/pacman/pkg --cachedir {}", shellQuote(prefetchCacheDir()))
+                                        : "";
+            // - --repo: AUR packages are left to the parallel build scheduler when it is enabled
+            std::string RepoOnly = getConfig().AurParallel ? " --repo" : "";
+            // - --config: pacman.conf with the fastest probed mirror in front of the mirrorlist
+            std::string PacmanConf;
+            if (std::string Mirror = getConfig().MirrorProbe ? bestMirror() : ""; !Mirror.empty()) {
+              PacmanConf = std::format(" --config {}", shellQuote(writePacmanConf(cacheDir() + "/update.conf", {.Server = Mirror})));
+            }
+            std::string Cmd = std::format("export SUDO_ASKPASS={0} && sudo -A -v && rm -f {0}.used && paru -Syu --noconfirm "
+                                          "--color=never --sudoflags -A --sudoloop --skipreview{1}{2}{3}",
+                                          CurrentTempFile, CacheDirs, RepoOnly, PacmanConf);
 
-            UpdatePipe.reset(popen(Cmd.c_str(), "r"));
+            // Runs with the configured priorities/limits so the desktop stays responsive
+            // Pagers (git, makepkg, paru) would block the same way, so they just print
+            bool Spawned = spawnPty(Cmd, UpdateProc, {{"PAGER", "cat"}, {"GIT_PAGER", "cat"}}, &getConfig().Resources);
 
             // Clear the environment variable now that the child process has been spawned
             unsetenv("IMUPDATE_PASS");
 
-            if (!UpdatePipe) {
-              LiveOutputBuffer += "Failed to execute command via popen().";
+            if (!Spawned) {
+              LiveOutput.feed("Failed to execute command via forkpty().");
               UpdateRunning = false;
               // Cleanup if popen fails
               if (fs::exists(CurrentTempFile))
@@ -302,8 +799,8 @@ void showUpdateGui(bool runInTray) {
               if (fs::exists(UsedFile))
                 fs::remove(UsedFile);
             } else {
-              PipeFD = fileno(UpdatePipe.get());
-              fcntl(PipeFD, F_SETFL, O_NONBLOCK);
+              Transaction.reset(parseUpdateList(InitialUpdateList), Clock::now());
+              if (getConfig().AurParallel) AurPassword = Password;
 
               // Clear password from memory for better security
               memset(Password, 0, sizeof(Password));
@@ -313,6 +810,22 @@ void showUpdateGui(bool runInTray) {
       }
       ImGui::EndDisabled();
 
+      if (UpdateRunning) {
+        ImGui::SameLine();
+        // Interrupts the whole process group; the output keeps streaming until it has exited
+        bool CanCancel = !UpdateCancelled && !(UpdateProc.active() && Committing());
+        ImGui::BeginDisabled(!CanCancel);
+        if (ImGui::Button("Cancel")) {
+          UpdateCancelled = true;
+          if (UpdateProc.active()) stopPty(UpdateProc);
+          AurBuilds.cancel();
+        }
+        ImGui::EndDisabled();
+        if (!UpdateCancelled && !CanCancel && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+          ImGui::SetTooltip("pacman is committing the transaction and can't be stopped safely");
+        }
+      }
+
       ImGui::SameLine();
       if (ImGui::Button("Close")) {
         // Ensure cleanup on exit
@@ -329,59 +842,76 @@ void showUpdateGui(bool runInTray) {
         }
       }
 
-      ImGui::Separator();
-      ImGui::AlignTextToFramePadding();
-      ImGui::Text("Output:");
-
-      ImGui::BeginChild("OutputRegion", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
-
-      static bool AutoScroll = true;
-      if (ImGui::GetScrollY() >= ImGui::GetScrollMaxY() - 1.0f) {
-        AutoScroll = true;
-      } else {
-        AutoScroll = false;
+      if (getConfig().Prefetch && Cached.Total > 0) {
+        ImGui::Text("Pre-downloaded: %d/%d packages (%.1f MiB)%s", Cached.Cached, Cached.Total,
+                    Cached.CachedBytes / (1024.0 * 1024.0), PrefetchProc.active() ? " - downloading..." : "");
       }
 
-      const std::string &OutputText = LiveOutputBuffer.empty() ? InitialUpdateList : LiveOutputBuffer;
+      if (CheckFailed) {
+        ImGui::TextColored(ImVec4(1.0f, 0.35f, 0.35f, 1.0f), "The last check failed: the sync databases could not be downloaded.");
+        ImGui::TextColored(ImVec4(1.0f, 0.35f, 0.35f, 1.0f), "The list below is from the check before it.");
+      }
 
-      ImVec2 textSize = ImGui::CalcTextSize(OutputText.c_str());
-      float width = std::max(ImGui::GetContentRegionAvail().x, textSize.x);
+      if (!FastestMirror.empty()) {
+        ImGui::Text("Fastest mirror: %s", FastestMirror.c_str());
+      }
 
-      int lineCount = 1;
-      for (char c : OutputText) {
-          if (c == '\n') lineCount++;
+      if (AurBuilds.planning()) {
+        ImGui::Text("Planning AUR builds: looking up dependencies...");
       }
-      // Provide an exact exact matching height (a little extra space doesn't hurt but the exact is minimum needed to avoid scrollbar)
-      float calculatedHeight = lineCount * ImGui::GetTextLineHeight() + ImGui::GetStyle().FramePadding.y * 2.0f + ImGui::GetTextLineHeight();
 
-      ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0, 0, 0, 0)); // Transparent background
-      ImGui::InputTextMultiline("##text", const_cast<char *>(OutputText.c_str()), OutputText.size() + 1,
-                                ImVec2(width, calculatedHeight),
-                                ImGuiInputTextFlags_ReadOnly | ImGuiInputTextFlags_NoHorizontalScroll);
-      ImGui::PopStyleColor();
+      drawTransactionTimings(Transaction);
 
-      if (AutoScroll) {
-        ImGui::SetScrollHereY(1.0f);
+      ImGui::Separator();
+      ImGui::AlignTextToFramePadding();
+      ImGui::Text("Output:");
+
+      // Before an update runs, the parsed list is shown so new entries can be highlighted
+      auto DrawMainOutput = [&]() {
+        if (!LiveOutput.empty()) {
+          drawLogView("OutputRegion", LiveOutput, LiveIndex, LiveView);
+        } else if (!CurrentUpdates.empty()) {
+          drawUpdateList(CurrentUpdates, NewNames);
+        } else {
+          // Nothing pending, or a list that didn't parse; either way only a few lines
+          ImGui::BeginChild("OutputRegion", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
+          ImGui::TextUnformatted(InitialUpdateList.c_str());
+          ImGui::EndChild();
+        }
+      };
+
+      if (AurBuilds.jobs().empty()) {
+        DrawMainOutput();
+      } else if (ImGui::BeginTabBar("OutputTabs")) {
+        // One log channel per AUR build, plus the batched installs
+        if (ImGui::BeginTabItem("Output")) {
+          DrawMainOutput();
+          ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("AUR install")) {
+          drawOutputRegion("InstallRegion", AurBuilds.installLog());
+          ImGui::EndTabItem();
+        }
+        for (const AurJob &Job : AurBuilds.jobs()) {
+          std::string Label = std::format("{} ({})###{}", Job.Name, buildStateName(Job.State), Job.Name);
+          if (ImGui::BeginTabItem(Label.c_str())) {
+            drawOutputRegion("BuildRegion", Job.Log);
+            ImGui::EndTabItem();
+          }
+        }
+        ImGui::EndTabBar();
       }
 
-      ImGui::EndChild();
       ImGui::End();
     }
 
     // --- 6d. Render ---
-    int DisplayW, DisplayH;
-    glfwGetFramebufferSize(Window, &DisplayW, &DisplayH);
-    glViewport(0, 0, DisplayW, DisplayH);
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-    glfwSwapBuffers(Window);
+    Settling = renderFrame(Window, LowOverhead ? &g_Frames : nullptr);
   }
 
   // --- 7. Cleanup ---
+  AcknowledgeNew();
+
   // Final safeguard cleanup
   if (!CurrentTempFile.empty()) {
     if (fs::exists(CurrentTempFile)) fs::remove(CurrentTempFile);
@@ -393,9 +923,232 @@ void showUpdateGui(bool runInTray) {
       tray_exit();
   }
 
-  ImGui_ImplOpenGL3_Shutdown();
-  ImGui_ImplGlfw_Shutdown();
-  ImGui::DestroyContext();
-  glfwDestroyWindow(Window);
-  glfwTerminate();
+  destroyWindow(Window);
+}
+
+void showFleetGui(const std::string &HostsFile) {
+  GLFWwindow *Window = createWindow("Fleet Updates");
+  ImGuiIO &io = ImGui::GetIO();
+
+  FleetClient Fleet(loadFleetHosts(HostsFile));
+  Fleet.refresh();
+  auto LastRefresh = std::chrono::steady_clock::now();
+
+  // Rows are only rebuilt when a host answers, not every frame
+  struct FleetRowView {
+    std::string Package;
+    std::string Hosts;
+    std::string Versions;
+    int HostCount;
+  };
+  std::vector<FleetRowView> Rows;
+  bool RowsDirty = true;
+
+  const bool LowOverhead = lowOverheadRendering();
+  const double StreamWait = 1.0 / getConfig().StreamFps;
+  bool Settling = true;
+
+  while (!glfwWindowShouldClose(Window)) {
+    if (LowOverhead) {
+      // Answers arrive on the sockets, not as window events, so wait less while hosts are pending
+      glfwWaitEventsTimeout(Fleet.busy() || Settling ? StreamWait : IdleWait);
+    } else {
+      glfwPollEvents();
+    }
+
+    // All hosts are multiplexed on this thread; never wait here, the frame pacing does that
+    RowsDirty |= Fleet.poll(0);
+    if (!Fleet.busy() && std::chrono::steady_clock::now() - LastRefresh > std::chrono::seconds(getConfig().FleetRefresh)) {
+      Fleet.refresh();
+      LastRefresh = std::chrono::steady_clock::now();
+    }
+
+    if (RowsDirty) {
+      Rows.clear();
+      for (const auto &[Package, Entries] : Fleet.table()) {
+        std::string Hosts;
+        for (const FleetEntry &Entry : Entries) {
+          Hosts += (Hosts.empty() ? "" : ", ") + Fleet.hosts()[Entry.Host].Name;
+        }
+        Rows.push_back({Package, Hosts, summarizeVersions(Entries), static_cast<int>(Entries.size())});
+      }
+      RowsDirty = false;
+    }
+
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplGlfw_NewFrame();
+    ImGui::NewFrame();
+
+    ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+    ImGui::SetNextWindowSize(io.DisplaySize);
+    ImGui::Begin("Fleet Window", nullptr,
+                 ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse |
+                     ImGuiWindowFlags_NoSavedSettings);
+
+    int Answered = 0, Failed = 0;
+    for (const FleetHost &Host : Fleet.hosts()) {
+      Answered += Host.State == HostState::Done;
+      Failed += Host.State == HostState::Failed;
+    }
+    ImGui::Text("Hosts: %zu (%d answered, %d failed) - %zu packages", Fleet.hosts().size(), Answered, Failed, Rows.size());
+    ImGui::SameLine();
+    ImGui::BeginDisabled(Fleet.busy());
+    if (ImGui::Button("Refresh")) {
+      Fleet.refresh();
+      LastRefresh = std::chrono::steady_clock::now();
+    }
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    if (ImGui::Button("Close")) {
+      glfwSetWindowShouldClose(Window, true);
+    }
+
+    if (ImGui::CollapsingHeader("Hosts")) {
+      if (ImGui::BeginTable("HostTable", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp,
+                            ImVec2(0, ImGui::GetTextLineHeightWithSpacing() * 8))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Host");
+        ImGui::TableSetupColumn("State");
+        ImGui::TableSetupColumn("Updates");
+        ImGui::TableSetupColumn("Error");
+        ImGui::TableHeadersRow();
+        ImGuiListClipper Clipper;
+        Clipper.Begin(static_cast<int>(Fleet.hosts().size()));
+        while (Clipper.Step()) {
+          for (int I = Clipper.DisplayStart; I < Clipper.DisplayEnd; ++I) {
+            const FleetHost &Host = Fleet.hosts()[I];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(Host.Name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(hostStateName(Host.State));
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", Host.Updates.size());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(Host.Error.c_str());
+          }
+        }
+        ImGui::EndTable();
+      }
+    }
+
+    if (ImGui::BeginTable("PackageTable", 3,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp)) {
+      ImGui::TableSetupScrollFreeze(0, 1);
+      ImGui::TableSetupColumn("Package");
+      ImGui::TableSetupColumn("Hosts");
+      ImGui::TableSetupColumn("Versions");
+      ImGui::TableHeadersRow();
+      // Only visible rows are submitted, the table can have thousands of them
+      ImGuiListClipper Clipper;
+      Clipper.Begin(static_cast<int>(Rows.size()));
+      while (Clipper.Step()) {
+        for (int I = Clipper.DisplayStart; I < Clipper.DisplayEnd; ++I) {
+          const FleetRowView &Row = Rows[I];
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(Row.Package.c_str());
+          ImGui::TableNextColumn();
+          ImGui::Text("%d", Row.HostCount);
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("%s", Row.Hosts.c_str());
+          }
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted(Row.Versions.c_str());
+        }
+      }
+      ImGui::EndTable();
+    }
+
+    ImGui::End();
+    Settling = renderFrame(Window, LowOverhead ? &g_Frames : nullptr);
+  }
+
+  destroyWindow(Window);
+}
+
+int runRenderBenchmark() {
+  // Mesa's software rasterizer, unless the caller picked a driver already
+  setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+  GLFWwindow *Window = createWindow("Render Benchmark");
+  ImGuiIO &io = ImGui::GetIO();
+  const char *Renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+  std::cout << std::format("Renderer: {}\n", Renderer ? Renderer : "unknown");
+
+  // Wall-clock scenario: an update log streams in, then the finished log just stays on screen.
+  // Each mode is paced like the real loop, and what counts is the CPU time the process used.
+  constexpr double StreamSeconds = 5.0;
+  constexpr double IdleSeconds = 3.0;
+  constexpr double LinesPerSecond = 20.0;
+  // Full mode waits for vsync; the cap also holds where the driver doesn't block on it
+  constexpr std::chrono::duration<double> FullFrameTime(1.0 / 60.0);
+  const double StreamWait = 1.0 / getConfig().StreamFps;
+  const int TotalLines = static_cast<int>(StreamSeconds * LinesPerSecond);
+
+  auto CpuSeconds = []() {
+    timespec Now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &Now);
+    return Now.tv_sec + Now.tv_nsec / 1e9;
+  };
+
+  TerminalBuffer Log;
+  LogIndex Index(Log, getConfig().HighlightErrors, getConfig().HighlightWarnings);
+  LogView View;
+
+  for (bool Low : {false, true}) {
+    FrameSkipper Skipper;
+    Log.clear();
+    int Fed = 0;
+    bool Settling = true;
+    for (bool Streaming : {true, false}) {
+      const double Seconds = Streaming ? StreamSeconds : IdleSeconds;
+      int Frames = 0, Drawn = 0;
+      const double CpuStart = CpuSeconds();
+      const auto Start = Clock::now();
+      auto NextFrame = Start;
+      auto Elapsed = [&]() { return std::chrono::duration<double>(Clock::now() - Start).count(); };
+
+      while (true) {
+        if (Low) {
+          glfwWaitEventsTimeout(Streaming || Settling ? StreamWait : IdleWait);
+        } else {
+          glfwPollEvents();
+        }
+        if (Elapsed() >= Seconds) break;
+
+        // Whatever the command would have printed by now
+        for (int Due = Streaming ? static_cast<int>(Elapsed() * LinesPerSecond) : 0; Fed < Due; ++Fed) {
+          Log.feed(std::format("({}/{}) upgrading package-{:<24} [{:<20}] {:3}%\n", Fed + 1, TotalLines, Fed,
+                               std::string(Fed % 21, '#'), Fed % 21 * 5));
+        }
+
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+        ImGui::SetNextWindowSize(io.DisplaySize);
+        ImGui::Begin("Benchmark Window", nullptr,
+                     ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
+                         ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings);
+        drawLogView("BenchmarkRegion", Log, Index, View);
+        ImGui::End();
+        Settling = renderFrame(Window, Low ? &Skipper : nullptr);
+        ++Frames;
+        Drawn += Settling;
+
+        if (!Low) {
+          // A frame slower than the cap starts the next one right away instead of catching up later
+          NextFrame = std::max(NextFrame + std::chrono::duration_cast<Clock::duration>(FullFrameTime), Clock::now());
+          std::this_thread::sleep_until(NextFrame);
+        }
+      }
+
+      const double Wall = Elapsed();
+      std::cout << std::format("{:<4} {:<9}: {:4} frames, {:4} drawn in {:.1f} s; {:.1f}% of a core\n", Low ? "low" : "full",
+                               Streaming ? "streaming" : "idle", Frames, Drawn, Wall, (CpuSeconds() - CpuStart) / Wall * 100.0);
+    }
+  }
+
+  destroyWindow(Window);
+  return 0;
 }
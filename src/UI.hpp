@@ -1,3 +1,8 @@
 #pragma once
 
+#include <string>
+
 void showUpdateGui(bool runInTray);
+void showFleetGui(const std::string &HostsFile);
+// Draws a streaming log on a software rasterizer in both render modes and prints the cost per frame
+int runRenderBenchmark();
@@ -1,27 +1,102 @@
 #include "Updates.hpp"
 #include "Utils.hpp"
+#include "SyncDb.hpp"
+#include "Config.hpp"
 #include <regex>
 #include <fstream>
 #include <iostream>
 #include <format>
 #include <filesystem>
+#include <sstream>
+#include <algorithm>
+#include <optional>
 
-void checkUpdates(bool Debug) {
+std::string repoUpdatesPath() { return cacheDir() + "/repo_updates"; }
+
+std::string aurUpdatesPath() { return cacheDir() + "/aur_updates"; }
+
+bool checkUpdates(bool Debug) {
   std::string UpdateList = "";
-  UpdateList += executeCommand("checkupdates", Debug);
-  UpdateList += executeCommand("paru -Qua", Debug);
+  // Our own sync DBs only download what changed since the last check, and the prefetch reuses them
+  std::optional<std::string> RepoUpdates = checkRepoUpdates(Debug);
+  if (!RepoUpdates) {
+    // An empty list would claim the system is up to date; the last good one is closer to the truth
+    std::cerr << "Checking for updates failed: the sync databases could not be downloaded\n";
+    return false;
+  }
+  std::string RepoList = std::move(*RepoUpdates);
+  std::string AurList = executeCommand("paru -Qua", Debug);
+  UpdateList += RepoList;
+  UpdateList += AurList;
 
   // Remove ANSI color codes from the output
   static const std::regex AnsiRegex("\x1B\\[[0-9;]*[mK]");
   std::string CleanUpdateList = std::regex_replace(UpdateList, AnsiRegex, "");
 
-  std::ofstream OutFile("/tmp/updates_list");
-  if (!OutFile.is_open()) {
-    if (Debug) {
-      std::cerr << std::format("Error writing to {}\n", "/tmp/updates_list");
+  // An unchanged list leaves the file alone, so nothing watching it sees a change
+  if (!std::filesystem::exists("/tmp/updates_list") || readFile("/tmp/updates_list") != CleanUpdateList) {
+    std::ofstream OutFile("/tmp/updates_list");
+    if (!OutFile.is_open()) {
+      if (Debug) {
+        std::cerr << std::format("Error writing to {}\n", "/tmp/updates_list");
+      }
+      exit(EXIT_FAILURE);
+    }
+    // Write the "clean" list to the file
+    OutFile << CleanUpdateList;
+  }
+
+  // Repo and AUR updates on their own, for prefetching and the AUR build scheduler
+  std::ofstream RepoFile(repoUpdatesPath());
+  RepoFile << std::regex_replace(RepoList, AnsiRegex, "");
+  std::ofstream AurFile(aurUpdatesPath());
+  AurFile << std::regex_replace(AurList, AnsiRegex, "");
+  return true;
+}
+
+std::vector<PackageUpdate> parseUpdateList(std::string_view List) {
+  // Lines look like "name 1.0-1 -> 1.1-1" (checkupdates and paru -Qua agree on this)
+  std::vector<PackageUpdate> Updates;
+  std::istringstream Stream{std::string(List)};
+  std::string Line;
+  while (std::getline(Stream, Line)) {
+    std::istringstream Fields(Line);
+    PackageUpdate Update;
+    std::string Arrow;
+    if (Fields >> Update.Name >> Update.OldVersion >> Arrow >> Update.NewVersion && Arrow == "->") {
+      Updates.push_back(std::move(Update));
+    }
+  }
+  return Updates;
+}
+
+std::string formatUpdateList(const std::vector<PackageUpdate> &Updates) {
+  std::string List;
+  for (const PackageUpdate &Update : Updates) {
+    List += std::format("{} {} -> {}\n", Update.Name, Update.OldVersion, Update.NewVersion);
+  }
+  return List;
+}
+
+void sortUpdates(std::vector<PackageUpdate> &Updates) { std::ranges::sort(Updates, {}, &PackageUpdate::Name); }
+
+UpdateDelta diffUpdates(const std::vector<PackageUpdate> &Old, const std::vector<PackageUpdate> &New) {
+  // Single sorted merge over both lists
+  UpdateDelta Delta;
+  auto OldIt = Old.begin();
+  auto NewIt = New.begin();
+  while (OldIt != Old.end() || NewIt != New.end()) {
+    if (NewIt == New.end() || (OldIt != Old.end() && OldIt->Name < NewIt->Name)) {
+      Delta.Removed.push_back(*OldIt++);
+    } else if (OldIt == Old.end() || NewIt->Name < OldIt->Name) {
+      Delta.Added.push_back(*NewIt++);
+    } else {
+      if (OldIt->NewVersion != NewIt->NewVersion || OldIt->OldVersion != NewIt->OldVersion) {
+        Delta.Bumped.push_back(*NewIt);
+      }
+      ++OldIt;
+      ++NewIt;
     }
-    exit(EXIT_FAILURE);
   }
-  // Write the "clean" list to the file
-  OutFile << CleanUpdateList;
+  return Delta;
 }
@@ -1,3 +1,32 @@
 #pragma once
 
-void checkUpdates(bool Debug = false);
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct PackageUpdate {
+  std::string Name;
+  std::string OldVersion;
+  std::string NewVersion;
+};
+
+// What changed between two update lists
+struct UpdateDelta {
+  std::vector<PackageUpdate> Added;
+  std::vector<PackageUpdate> Removed;
+  std::vector<PackageUpdate> Bumped; // Still pending, with different versions (new ones listed)
+
+  bool empty() const { return Added.empty() && Removed.empty() && Bumped.empty(); }
+};
+
+// Writes the update list to /tmp/updates_list; other checks write the same file. False when the
+// repos could not be checked, in which case the previous list is left in place.
+bool checkUpdates(bool Debug = false);
+// Repo and AUR halves of the last check
+std::string repoUpdatesPath();
+std::string aurUpdatesPath();
+std::vector<PackageUpdate> parseUpdateList(std::string_view List);
+std::string formatUpdateList(const std::vector<PackageUpdate> &Updates);
+void sortUpdates(std::vector<PackageUpdate> &Updates);
+// Both lists must be sorted by name
+UpdateDelta diffUpdates(const std::vector<PackageUpdate> &Old, const std::vector<PackageUpdate> &New);
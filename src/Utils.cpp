@@ -7,6 +7,8 @@
 #include <sstream>
 #include <filesystem>
 #include <format>
+#include <cstdlib>
+#include <algorithm>
 
 namespace fs = std::filesystem;
 
@@ -32,6 +34,33 @@ std::string executeCommand(const char *Cmd, bool Debug) {
   return Result;
 }
 
+std::vector<std::string> executeCommands(const std::vector<std::string> &Cmds, std::size_t MaxParallel, bool Debug) {
+  std::vector<std::string> Results(Cmds.size());
+  std::array<char, 4096> Buffer;
+  if (MaxParallel == 0) MaxParallel = 1;
+
+  // Every command of a batch is started before any output is read, so they run concurrently
+  for (std::size_t First = 0; First < Cmds.size(); First += MaxParallel) {
+    std::size_t Last = std::min(Cmds.size(), First + MaxParallel);
+    std::vector<std::unique_ptr<FILE, PipeDeleter>> Pipes;
+    for (std::size_t I = First; I < Last; ++I) {
+      std::string Command = Debug ? Cmds[I] : std::format("{{ {}; }} 2>/dev/null", Cmds[I]);
+      Pipes.emplace_back(popen(Command.c_str(), "r"));
+      if (!Pipes.back() && Debug) {
+        std::cerr << std::format("popen() failed for command: {}\n", Cmds[I]);
+      }
+    }
+    for (std::size_t I = First; I < Last; ++I) {
+      FILE *Pipe = Pipes[I - First].get();
+      if (!Pipe) continue;
+      while (size_t BytesRead = fread(Buffer.data(), 1, Buffer.size(), Pipe)) {
+        Results[I].append(Buffer.data(), BytesRead);
+      }
+    }
+  }
+  return Results;
+}
+
 int getLineCount(std::string_view Filename) {
   std::ifstream File{fs::path(Filename)};
   if (!File.is_open()) {
@@ -55,3 +84,61 @@ std::string readFile(std::string_view Filename) {
   Buffer << File.rdbuf();
   return Buffer.str();
 }
+
+std::string cacheDir() {
+  // $XDG_CACHE_HOME/imupdate, falling back to ~/.cache/imupdate
+  fs::path Dir;
+  if (const char *Xdg = getenv("XDG_CACHE_HOME"); Xdg && *Xdg) {
+    Dir = Xdg;
+  } else if (const char *Home = getenv("HOME"); Home && *Home) {
+    Dir = fs::path(Home) / ".cache";
+  } else {
+    Dir = "/tmp";
+  }
+  Dir /= "imupdate";
+  std::error_code Ec;
+  fs::create_directories(Dir, Ec);
+  return Dir.string();
+}
+
+std::string shellQuote(std::string_view Arg) {
+  // Single quotes, with embedded ones closed, escaped and reopened
+  std::string Quoted = "'";
+  for (char C : Arg) {
+    if (C == '\'') {
+      Quoted += "'\\''";
+    } else {
+      Quoted += C;
+    }
+  }
+  Quoted += '\'';
+  return Quoted;
+}
+
+std::string expandPlaceholders(std::string_view Template,
+                               std::initializer_list<std::pair<std::string_view, std::string_view>> Values) {
+  // Replaces "{name}" with the matching value; unknown placeholders are kept as they are
+  std::string Result;
+  std::size_t Pos = 0;
+  while (Pos < Template.size()) {
+    std::size_t Open = Template.find('{', Pos);
+    std::size_t Close = Open == std::string_view::npos ? Open : Template.find('}', Open);
+    if (Close == std::string_view::npos) {
+      Result += Template.substr(Pos);
+      break;
+    }
+    Result += Template.substr(Pos, Open - Pos);
+    std::string_view Name = Template.substr(Open + 1, Close - Open - 1);
+    bool Found = false;
+    for (const auto &[Key, Value] : Values) {
+      if (Key == Name) {
+        Result += Value;
+        Found = true;
+        break;
+      }
+    }
+    if (!Found) Result += Template.substr(Open, Close - Open + 1);
+    Pos = Close + 1;
+  }
+  return Result;
+}
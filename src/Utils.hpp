@@ -3,11 +3,19 @@
 #include <string>
 #include <string_view>
 #include <cstdio>
+#include <initializer_list>
+#include <utility>
+#include <vector>
 
 struct PipeDeleter {
   void operator()(FILE* fp) const { if (fp) pclose(fp); }
 };
 
 std::string executeCommand(const char* Cmd, bool Debug = false);
+std::vector<std::string> executeCommands(const std::vector<std::string> &Cmds, std::size_t MaxParallel, bool Debug = false);
 int getLineCount(std::string_view Filename);
 std::string readFile(std::string_view Filename);
+std::string cacheDir();
+std::string shellQuote(std::string_view Arg);
+std::string expandPlaceholders(std::string_view Template,
+                               std::initializer_list<std::pair<std::string_view, std::string_view>> Values);
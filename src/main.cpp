@@ -1,7 +1,12 @@
 #include "Updates.hpp"
 #include "Utils.hpp"
 #include "UI.hpp"
+#include "Fleet.hpp"
+#include "Instance.hpp"
+#include "Config.hpp"
+#include "Mirrors.hpp"
 #include <iostream>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -10,6 +15,10 @@ int main(int argc, char *argv[]) {
   bool showUi = true;
   bool debug = false;
   bool runInTray = false;
+  bool refresh = false;
+  bool bench = false;
+  std::string fleetHosts = "";
+  std::string serveAddress = "";
 
   // Parse arguments
   for (int i = 1; i < argc; ++i) {
@@ -22,16 +31,73 @@ int main(int argc, char *argv[]) {
     if (std::string_view(argv[i]) == "-tray") {
       runInTray = true;
     }
+    if (std::string_view(argv[i]) == "-refresh") {
+      refresh = true;
+      showUi = false;
+    }
+    if (std::string_view(argv[i]) == "-bench") {
+      bench = true;
+    }
+    if (std::string_view(argv[i]) == "-fleet" && i + 1 < argc) {
+      fleetHosts = argv[++i];
+    }
+    if (std::string_view(argv[i]) == "-serve") {
+      // The address is optional; without one only this user can connect
+      serveAddress = i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : defaultServeAddress();
+    }
+  }
+
+  if (bench) {
+    return runRenderBenchmark();
+  }
+
+  // Expose this host's last update list to a fleet aggregator
+  if (!serveAddress.empty()) {
+    return serveUpdateList(serveAddress);
+  }
+
+  // Aggregate the update lists of many hosts instead of checking this one
+  if (!fleetHosts.empty()) {
+    if (!showUi) {
+      return printFleet(fleetHosts);
+    }
+    showFleetGui(fleetHosts);
+    return 0;
+  }
+
+  // A GUI that is already running answers instead: no second window and no second check
+  std::string request = refresh ? "refresh" : !showUi ? "count" : runInTray ? "ping" : "show";
+  if (std::optional<std::string> reply = sendToInstance(request)) {
+    if (request == "count") {
+      std::cout << *reply;
+    } else if (request == "ping") {
+      std::cerr << "imupdate is already running\n";
+    }
+    return 0;
   }
 
   if (showUi) {
+    if (!claimInstance()) {
+      // Another launch got there first, unless the address is squatted by another user
+      if (sendToInstance(runInTray ? "ping" : "show")) return 0;
+      std::cerr << "The instance address is held by another user or a closing instance, running without single-instance handling\n";
+    }
     showUpdateGui(runInTray);
+    // Nobody answers requests anymore; a launch during the check below starts its own GUI instead
+    releaseInstance();
   }
 
   // Unconditionally check updates
-  checkUpdates(debug);
+  if (!checkUpdates(debug)) {
+    return EXIT_FAILURE;
+  }
   int Updates = getLineCount("/tmp/updates_list");
   std::cout << Updates << std::endl;
 
+  // Rank mirrors once the result is out, so the next prefetch or update can start with the fastest one
+  if (getConfig().MirrorProbe) {
+    probeMirrors(debug);
+  }
+
   return 0;
 }
@@ -0,0 +1,105 @@
+#include "LogIndex.hpp"
+#include "Terminal.hpp"
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+
+static int g_Failures = 0;
+
+static void expect(bool Ok, const std::string &What) {
+  if (!Ok) {
+    std::cerr << std::format("FAILED: {}\n", What);
+    ++g_Failures;
+  }
+}
+
+static void expectText(const TerminalBuffer &Buffer, const std::string &Expected, const std::string &What) {
+  expect(Buffer.text() == Expected, std::format("{}: got \"{}\", expected \"{}\"", What, Buffer.text(), Expected));
+}
+
+static void testVerticalMoves() {
+  // Two parallel download bars, redrawn in place by moving back up over them
+  TerminalBuffer Buffer;
+  Buffer.feed("a  10%\nb  20%\n");
+  Buffer.feed("\x1B[2Aa  50%\n\x1B[Kb  60%\n");
+  expectText(Buffer, "a  50%\nb  60%\n", "cursor up redraws earlier lines");
+
+  Buffer.clear();
+  Buffer.feed("one\ntwo\nthree");
+  Buffer.feed("\x1B[2FONE\x1B[1Ex");
+  expectText(Buffer, "ONE\nxwo\nthree", "previous/next line move to column 0");
+
+  // Writing past the end of a line that isn't the last one must not touch the lines below
+  Buffer.clear();
+  Buffer.feed("ab\ncd\nef");
+  Buffer.feed("\x1B[2A\x1B[5Gz");
+  expectText(Buffer, "ab  z\ncd\nef", "write past the end of an upper line");
+  Buffer.feed("\x1B[1E\x1B[K");
+  expectText(Buffer, "ab  z\n\nef", "erase an upper line");
+  expect(Buffer.lineCount() == 3 && Buffer.line(0) == "ab  z" && Buffer.line(1).empty() && Buffer.line(2) == "ef",
+         "line offsets follow rewritten lines");
+
+  // Moves can't leave the screen or go below the last line
+  Buffer.clear();
+  Buffer.feed("x\x1B[5Ay\x1B[5Bz");
+  expectText(Buffer, "xyz", "moves stop at the first and last line");
+
+  // Finished lines only become uncommitted while the cursor is above them
+  Buffer.clear();
+  Buffer.feed("one\ntwo\n");
+  expect(Buffer.committedSize() == 8, "committed up to the cursor line");
+  Buffer.feed("\x1B[2A");
+  expect(Buffer.committedSize() == 0, "moving up uncommits the lines below");
+  Buffer.feed("\n\n");
+  expect(Buffer.committedSize() == 8, "moving back down commits them again");
+
+  // Only the last PtyRows lines can be reached
+  Buffer.clear();
+  for (int Line = 0; Line < PtyRows + 10; ++Line) Buffer.feed("line\n");
+  Buffer.feed("\x1B[99A");
+  expect(Buffer.committedSize() == Buffer.text().size() - (PtyRows - 1) * 5, "cursor up stops at the top of the screen");
+}
+
+static void testClampedParameters() {
+  TerminalBuffer Buffer;
+  Buffer.feed("\x1B[99999999Gx");
+  expect(Buffer.text().size() == PtyColumns, std::format("column is clamped to the screen width, line is {} bytes", Buffer.text().size()));
+
+  Buffer.clear();
+  Buffer.feed("\x1B[99999999999999999999Cx");
+  expect(Buffer.text().size() <= PtyColumns, "an overflowing count doesn't move past the screen");
+
+  Buffer.clear();
+  Buffer.feed("abc\x1B[99999999Dx");
+  expectText(Buffer, "xbc", "cursor back stops at column 0");
+}
+
+static void testIndexRollback() {
+  TerminalBuffer Buffer;
+  LogIndex Index(Buffer, {"error"}, {"warning"});
+  Index.setQuery("bar");
+  Buffer.feed("ok\nbar error\nbar warning\n");
+  Index.update();
+  expect(Index.lines(Severity::Error).size() == 1 && Index.lines(Severity::Warning).size() == 1, "patterns indexed");
+  expect(Index.matches().size() == 2, "query matches indexed");
+
+  // The last two lines are rewritten without the patterns
+  Buffer.feed("\x1B[2Abar fine\x1B[K\nbar fine\x1B[K\n");
+  Index.update();
+  expect(Index.lines(Severity::Error).empty() && Index.lines(Severity::Warning).empty(), "rewritten lines are re-indexed");
+  expect(Index.matches().size() == 2, "query matches are found again");
+  expect(Index.lineCount() == 4, std::format("line count after rewrite is {}", Index.lineCount()));
+}
+
+int main() {
+  testVerticalMoves();
+  testClampedParameters();
+  testIndexRollback();
+  if (g_Failures > 0) {
+    std::cerr << std::format("{} check(s) failed\n", g_Failures);
+    return EXIT_FAILURE;
+  }
+  std::cout << "All terminal checks passed\n";
+  return EXIT_SUCCESS;
+}